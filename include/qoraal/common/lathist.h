@@ -0,0 +1,76 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+/**
+ * @file    lathist.h
+ * @brief   Latency histogram.
+ * @details Eight buckets, each four times as wide as the one before:
+ *
+ *              <16us <64us <256us <1ms <4ms <16ms <65ms >=65ms
+ *
+ *          Cheap enough to update on every delivery, with the maximum kept
+ *          alongside for the tail the last bucket hides.
+ */
+
+#ifndef __LATHIST_H__
+#define __LATHIST_H__
+
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Constants.                                                                */
+/*===========================================================================*/
+
+#define LATHIST_BUCKETS                 8
+
+/** Upper bound in us of bucket idx, the last bucket has none. */
+#define LATHIST_BUCKET_US(idx)          ((uint32_t)16 << (2*(idx)))
+
+/*===========================================================================*/
+/* Data structures and types.                                                */
+/*===========================================================================*/
+
+typedef struct LATHIST_S {
+    uint32_t            bucket[LATHIST_BUCKETS] ;
+    uint32_t            max_us ;
+} LATHIST_T ;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+static inline void
+lathist_add (LATHIST_T * hist, uint32_t us)
+{
+    uint32_t idx = 0 ;
+
+    while ((idx < LATHIST_BUCKETS - 1) && (us >= LATHIST_BUCKET_US(idx))) {
+        idx++ ;
+    }
+    hist->bucket[idx]++ ;
+    if (us > hist->max_us) {
+        hist->max_us = us ;
+    }
+}
+
+#endif /* __LATHIST_H__ */
@@ -28,8 +28,8 @@
 /* Data structures and types.                                                */
 /*===========================================================================*/
 typedef struct  {
-    RTCLIB_DATE_T   date ;
-    RTCLIB_TIME_T   time ;
+    uint32_t        seconds ;   /**< since the epoch, see rtc_localtime() */
+    uint32_t        nsec ;
     uint16_t        cnt ;
     uint16_t        id ;
     union {
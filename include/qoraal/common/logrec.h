@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+/**
+ * @file    logrec.h
+ * @brief   Structured log record fields.
+ * @details Typed key/value fields are encoded into a compact binary record
+ *          that follows the terminator of the log message text, in logger
+ *          tasks and in mlog entries alike:
+ *
+ *              "message text" '\0' field field ...
+ *
+ *          Each field is encoded as:
+ *
+ *              type    1 byte, LOGREC_TYPE_T
+ *              keylen  1 byte
+ *              key     keylen bytes, not terminated
+ *              value   LOGREC_TYPE_INT:         zigzag LEB128 varint
+ *                      LOGREC_TYPE_UINT/HEX:    LEB128 varint
+ *                      LOGREC_TYPE_STR:         1 byte length and the bytes
+ *
+ *          Records are forwarded as is and only rendered as " key=value"
+ *          text where a human reads them.
+ */
+
+#ifndef __LOGREC_H__
+#define __LOGREC_H__
+
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Client pre-compile time settings.                                         */
+/*===========================================================================*/
+
+#define LOGREC_KEY_SIZE_MAX             32
+#define LOGREC_STR_SIZE_MAX             64
+
+/*===========================================================================*/
+/* Data structures and types.                                                */
+/*===========================================================================*/
+
+typedef enum {
+    LOGREC_TYPE_INT = 1,
+    LOGREC_TYPE_UINT,
+    LOGREC_TYPE_HEX,
+    LOGREC_TYPE_STR,
+    LOGREC_TYPE_LAST
+} LOGREC_TYPE_T ;
+
+/*
+ * When decoding, key and s point into the record and are not terminated,
+ * key_len and len give their lengths.
+ */
+typedef struct LOGREC_FIELD_S {
+    const char *        key ;
+    uint8_t             type ;
+    uint8_t             key_len ;
+    uint8_t             len ;
+    union {
+        int32_t         i ;
+        uint32_t        u ;
+        const char *    s ;
+    } ;
+} LOGREC_FIELD_T ;
+
+#define LOGREC_INT(key, val)            { key, LOGREC_TYPE_INT, 0, 0, { .i = (int32_t)(val) } }
+#define LOGREC_UINT(key, val)           { key, LOGREC_TYPE_UINT, 0, 0, { .u = (uint32_t)(val) } }
+#define LOGREC_HEX(key, val)            { key, LOGREC_TYPE_HEX, 0, 0, { .u = (uint32_t)(val) } }
+#define LOGREC_STR(key, val)            { key, LOGREC_TYPE_STR, 0, 0, { .s = (val) } }
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    uint32_t        logrec_size (const LOGREC_FIELD_T * fields, uint32_t count) ;
+    uint32_t        logrec_encode (uint8_t * record, uint32_t size, const LOGREC_FIELD_T * fields, uint32_t count) ;
+    const uint8_t * logrec_decode (const uint8_t * record, const uint8_t * end, LOGREC_FIELD_T * field) ;
+    uint32_t        logrec_render (char * buffer, uint32_t size, const uint8_t * record, uint32_t len) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOGREC_H__ */
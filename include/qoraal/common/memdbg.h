@@ -93,9 +93,20 @@ extern "C" {
 #define ASCII_SEPERATOR             " // "
 #define MEMDBG_NEWLINE              "\r\n"
 #endif
+#ifndef DBG_MEM_DUMP_WIDTH_MAX
+#define DBG_MEM_DUMP_WIDTH_MAX      32
+#endif
 /*==================================================================================================
                                             MACROS
 ==================================================================================================*/
+/* Characters in one dump line of w bytes, excluding the terminator. */
+#ifndef MEMDBG_MAKE_CARRAY
+#define DBG_MEM_DUMP_LINE_LENGTH(w) (int)(18 + (w) * (sizeof(DUMP_HEX_SEPERATOR_LEAD) + sizeof(DUMP_HEX_SEPERATOR_TRAIL)) + \
+                                    sizeof(ASCII_SEPERATOR) - 1 + (w) + sizeof(MEMDBG_NEWLINE) - 1)
+#else
+#define DBG_MEM_DUMP_LINE_LENGTH(w) (int)((w) * (sizeof(DUMP_HEX_SEPERATOR_LEAD) + sizeof(DUMP_HEX_SEPERATOR_TRAIL)) + \
+                                    sizeof(MEMDBG_NEWLINE) - 1)
+#endif
 
 /*==================================================================================================
                                      FUNCTION PROTOTYPES
@@ -105,6 +116,8 @@ extern "C" {
 char* dbg_format_mem_dump_buffer (char* buffer, int len, const char* data, int size, unsigned int print_addr) ;
 char* dbg_format_mem_dump_width (char* buffer, int len, const char* data, int size, unsigned int print_addr, int width) ;
 char* dbg_format_mem_2html_buffer (char* buffer, int buffer_len, const char* data, int size, unsigned int print_addr) ;
+int   dbg_format_mem_dump_render (char* line, const char* data, int size, unsigned int print_addr, int width) ;
+int   dbg_format_hex (char* buffer, const char* data, int size, unsigned int lower) ;
 
 #endif /* DEBUG */
 
@@ -64,6 +64,7 @@ extern "C" {
 
     int32_t         mlog_dbg (uint16_t type, uint16_t id, const char* msg, ...) ;
     int32_t         mlog_log (int16_t facillity,  int16_t severity, const char* msg, ...) ;
+    int32_t         mlog_record (int16_t facillity,  int16_t severity, const char* msg, const uint8_t * record, uint32_t len) ;
     int32_t         mlog_assert (const char* msg, ...) ;
 
     int32_t         mlog_total (uint16_t log) ;
@@ -94,6 +94,10 @@ typedef struct RTCLIB_TIME_S {
 
 
 #define RTCLIB_EPOCH_GDAY               2440588 // (1970*365 + 1970/4 - 1970/100 + 1970/400 + (1*306 + 5)/10 + (1 - 1))
+#ifndef RTCLIB_ANCHOR_CHECK_NS
+#define RTCLIB_ANCHOR_CHECK_NS          (10ULL * 1000000000ULL)
+#endif
+
 #define RTCLIB_SET_ALARM_MAX            ((604800/2) - 1)  // half week
 typedef void (*RTCLIB_ALARM_CALLBACK_T)(void) ;
 
@@ -110,6 +114,8 @@ RTCLIB_TIME_T   rtc_get_time (void) ;
 RTCLIB_DATE_T   rtc_get_date (void) ;
 
 void            rtc_localtime (uint32_t timestamp, RTCLIB_DATE_T* date, RTCLIB_TIME_T* time) ;
+void            rtc_localtime_ns (uint64_t timestamp_ns, RTCLIB_DATE_T* date, RTCLIB_TIME_T* time) ;
+uint64_t        rtc_epoch_ns (uint64_t timestamp_ns) ;
 uint32_t        rtc_time (void) ;
 uint32_t        rtc_mktime (RTCLIB_DATE_T date, RTCLIB_TIME_T time) ;
 RTCLIB_DATE_T   rtc_get_gdate(uint32_t jday) ;
@@ -4,6 +4,13 @@
 */
 // #define CFG_DEBUG_SVC_LOGGER_DISABLE    1
 
+/* CFG_DEBUG_SEVERITY_MAX
+    Highest severity compiled in by the DBG_MESSAGE_T_* macros. Anything
+    above it is removed at compile time, eg. SVC_LOGGER_SEVERITY_REPORT
+    strips log, info and debug messages from a release build.
+*/
+// #define CFG_DEBUG_SEVERITY_MAX          4
+
 /* CFG_SVC_THREADS_DISABLE_IDLE
     If defined, system should call svc_threads_complete_check() from an idle thread to cleanup 
     terminated threds.
@@ -46,6 +53,16 @@
 */
 // #define CFG_OS_MLOCK_DISABLE        1
 
+/* CFG_OS_RWLOCK_DISABLE
+    If defined, the platform does not support rwlock
+*/
+// #define CFG_OS_RWLOCK_DISABLE       1
+
+/* CFG_OS_QUEUE_DISABLE
+    If defined, the platform does not support the lock-free queue
+*/
+// #define CFG_OS_QUEUE_DISABLE        1
+
 /* CFG_QFS_DISABLE
     If defined, the platform does not support qfs
 */
@@ -50,6 +50,25 @@
 #define DBG_MESSAGE_GET_TYPE(severity, flags)               (SVC_LOGGER_TYPE(severity, flags))
 #define DBG_MESSAGE_GET_SEVERITY(type)                      (SVC_LOGGER_GET_SEVERITY(type))
 
+#if defined CFG_DEBUG_SEVERITY_MAX
+#define DBG_MESSAGE_SEVERITY_MAX                            (CFG_DEBUG_SEVERITY_MAX)
+#else
+#define DBG_MESSAGE_SEVERITY_MAX                            (DBG_MESSAGE_SEVERITY_DEBUG)
+#endif
+
+/*
+ * Severity ceilings fold away at compile time for constant types, the
+ * runtime gate is a single table lookup done before any argument is evaluated.
+ */
+#define DBG_MESSAGE_ENABLED(type, facility, ceiling)        \
+                        ((DBG_MESSAGE_GET_SEVERITY((type)) <= (ceiling)) && \
+                        (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_MAX) && \
+                        SVC_LOGGER_ENABLED((type), (facility)))
+
+#define DBG_MESSAGE_COMPILED(type, ceiling)                 \
+                        ((DBG_MESSAGE_GET_SEVERITY((type)) <= (ceiling)) && \
+                        (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_MAX))
+
 #ifdef NDEBUG
 
 #define DBG_MESSAGE_T(type, fmt_str, ...)
@@ -59,6 +78,7 @@
 #define DBG_MESSAGE_T_LOG(type, fmt_str, ...)
 #define DBG_MESSAGE_T_DEBUG(type, fmt_str, ...)
 #define DBG_MESSAGE_T_ASSERT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_ASSERT)   svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_RATELIMIT(type, facility, fmt_str, ...)
 #define DBG_ASSERT_T(cond, fmt_str, ...) 					(void) (cond)
 #define DBG_ASSERT_ISR_T(cond, fmt_str, ...)				(void) (cond)
 #define DBG_CHECK_T(cond, ret, fmtstr, ...)                 { if (!(cond)) { return ret ; } }
@@ -71,13 +91,22 @@
 
 #if !defined CFG_DEBUG_SVC_LOGGER_DISABLE
 
-#define DBG_MESSAGE_T(type, facility, fmt_str, ...)         {  svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_ERROR(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_ERROR)    svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_WARNING(type, facility, fmt_str, ...) {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_WARNING)  svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_REPORT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_REPORT)   svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_LOG(type, facility, fmt_str, ...)     {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_LOG)      svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_DEBUG(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_DEBUG)    svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_ASSERT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_ASSERT)   svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T(type, facility, fmt_str, ...)         {  if (SVC_LOGGER_ENABLED((type), (facility)))                                      svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_ERROR(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_ERROR))      svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_WARNING(type, facility, fmt_str, ...) {  if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_WARNING))    svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_REPORT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_REPORT))     svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_LOG(type, facility, fmt_str, ...)     {  if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_LOG))        svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_DEBUG(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_DEBUG))      svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_ASSERT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_ASSERT))     svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
+/*
+ * Rate limited per call site. Over the limit the message is counted, not
+ * formatted, and the count is reported when the call site passes again.
+ */
+#define DBG_MESSAGE_T_RATELIMIT(type, facility, fmt_str, ...) { \
+                                                            static SVC_LOGGER_RATELIMIT_DECL(_dbg_ratelimit_state) ; \
+                                                            if (DBG_MESSAGE_ENABLED((type), (facility), DBG_MESSAGE_SEVERITY_DEBUG) && \
+                                                                svc_logger_ratelimit (&_dbg_ratelimit_state, type, facility)) \
+                                                                svc_logger_type_log(type, facility, fmt_str, ##__VA_ARGS__) ; }
 
 #ifdef NDEBUG
 #define DBG_CHECK_T(cond, ret, fmtstr, ...)                 { if (!(cond)) { return ret ; } }
@@ -90,12 +119,13 @@
 #else
 
 #define DBG_MESSAGE_T(type, facility, fmt_str, ...)         {  debug_printf(fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_ERROR(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_ERROR)    debug_printf(fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_WARNING(type, facility, fmt_str, ...) {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_WARNING)  debug_printf(fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_REPORT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_REPORT)   debug_printf(fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_LOG(type, facility, fmt_str, ...)     {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_LOG)      debug_printf(fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_DEBUG(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_DEBUG)    debug_printf(fmt_str, ##__VA_ARGS__) ; }
-#define DBG_MESSAGE_T_ASSERT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_GET_SEVERITY((type)) <= DBG_MESSAGE_SEVERITY_ASSERT)   debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_ERROR(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_ERROR))    debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_WARNING(type, facility, fmt_str, ...) {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_WARNING))  debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_REPORT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_REPORT))   debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_LOG(type, facility, fmt_str, ...)     {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_LOG))      debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_DEBUG(type, facility, fmt_str, ...)   {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_DEBUG))    debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_ASSERT(type, facility, fmt_str, ...)  {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_ASSERT))   debug_printf(fmt_str, ##__VA_ARGS__) ; }
+#define DBG_MESSAGE_T_RATELIMIT(type, facility, fmt_str, ...) {  if (DBG_MESSAGE_COMPILED((type), DBG_MESSAGE_SEVERITY_DEBUG))    debug_printf(fmt_str, ##__VA_ARGS__) ; }
 
 #ifdef NDEBUG
 #define DBG_CHECK_T(cond, ret, fmtstr, ...)                 { if (!(cond)) { return ret ; } }
@@ -90,6 +90,29 @@
 #define OS_TIME_BEFORE32(b, a)      OS_TIME_AFTER32(a, b)
 /** @} */
 
+/**
+ * @name    Atomic Counter Macros
+ * @brief   Shared 32-bit counters updated without os_sys_lock(). ADD and
+ *          SUB return the new value. STORE publishes the writes before it,
+ *          FENCE orders everything before it against everything after.
+ * @{ */
+#if defined(__GNUC__) || defined(__clang__)
+#define OS_ATOMIC_ADD(ptr, val)     __atomic_add_fetch((ptr), (val), __ATOMIC_RELAXED)
+#define OS_ATOMIC_SUB(ptr, val)     __atomic_sub_fetch((ptr), (val), __ATOMIC_ACQ_REL)
+#define OS_ATOMIC_LOAD(ptr)         __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define OS_ATOMIC_STORE(ptr, val)   __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define OS_ATOMIC_FENCE()           __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define OS_ATOMIC_ADD(ptr, val)     os_sys_atomic_add ((volatile uint32_t *)(ptr), (uint32_t)(val))
+#define OS_ATOMIC_SUB(ptr, val)     os_sys_atomic_add ((volatile uint32_t *)(ptr), 0 - (uint32_t)(val))
+#define OS_ATOMIC_LOAD(ptr)         (*(volatile uint32_t *)(ptr))
+#define OS_ATOMIC_STORE(ptr, val)   (*(volatile uint32_t *)(ptr) = (uint32_t)(val))
+#define OS_ATOMIC_FENCE()           do { os_sys_lock () ; os_sys_unlock () ; } while (0)
+#endif
+#define OS_ATOMIC_INC(ptr)          OS_ATOMIC_ADD(ptr, 1)
+#define OS_ATOMIC_DEC(ptr)          OS_ATOMIC_SUB(ptr, 1)
+/** @} */
+
 /*===========================================================================*/
 /* OS data structures and types.                                         */
 /*===========================================================================*/
@@ -99,6 +122,16 @@
  */
 typedef void * p_thread_t;
 
+/**
+ * @brief Thread stack and CPU usage, as far as the backend measures them.
+ *        Zero where it does not.
+ */
+typedef struct OS_THREAD_STATS_S {
+    uint32_t    stack_size ;    /**< bytes requested at create */
+    uint32_t    stack_used ;    /**< most bytes of stack ever used */
+    uint64_t    runtime_us ;    /**< CPU time used by the thread */
+} OS_THREAD_STATS_T ;
+
 /**
  * @brief Typedef for a Semaphore.
  */
@@ -114,11 +147,42 @@ typedef void * p_event_t;
  */
 typedef void * p_mutex_t;
 
+/**
+ * @brief Mutex contention statistics, where the backend keeps them.
+ */
+typedef struct OS_MUTEX_STATS_S {
+    uint32_t    locks ;         /**< acquisitions */
+    uint32_t    contended ;     /**< acquisitions that found it held */
+    uint32_t    spun ;          /**< contended, but taken while spinning */
+    uint32_t    max_wait_us ;
+    uint64_t    wait_ns ;       /**< total time spent waiting */
+} OS_MUTEX_STATS_T ;
+
+/**
+ * @brief Callback for os_mutex_stats(). name is 0 for unnamed mutexes.
+ */
+typedef void (*p_mutex_stats_function_t)( void * arg, const char * name, p_mutex_t mutex, const OS_MUTEX_STATS_T * stats );
+
 /**
  * @brief Typedef for a MLock.
  */
 typedef void * p_mlock_t;
 
+/**
+ * @brief Typedef for a RWLock.
+ */
+typedef void * p_rwlock_t;
+
+/**
+ * @brief   RWLock flags. A waiting writer holds back new readers.
+ */
+#define OS_RWLOCK_FLAGS_WRITER_PREF             (1<<0)
+
+/**
+ * @brief Typedef for a lock-free pointer Queue.
+ */
+typedef void * p_queue_t;
+
 /**
  * @brief Typedef for a Thread Function Pointer.
  */
@@ -173,12 +237,14 @@ extern "C" {
     extern uint32_t     os_sys_tick_freq (void) ;
     extern uint32_t     os_sys_timestamp (void) ;
     extern uint32_t     os_sys_us_timestamp (void) ;
+    extern uint64_t     os_sys_ns_timestamp (void) ;
     extern void         os_sys_stop (void) ;
     extern void         os_sys_halt (const char * msg) ;
 
     extern int32_t      os_thread_create  (uint16_t stack_size, uint32_t prio, p_thread_function_t pf, void *arg, p_thread_t* thread, const char* name) ;
     extern int32_t      os_thread_create_static (void *wsp, uint16_t size, uint32_t prio, p_thread_function_t pf, void *arg, p_thread_t* thread, const char* name) ;
     extern const char*  os_thread_get_name (p_thread_t* thread);
+    extern int32_t      os_thread_get_stats (p_thread_t* thread, OS_THREAD_STATS_T * stats) ;
     extern p_thread_t   os_thread_current (void) ;
     extern void         os_thread_sleep (uint32_t msec);
     extern void         os_thread_sleep_ticks (uint32_t ticks);
@@ -196,6 +262,11 @@ extern "C" {
     extern int32_t      os_thread_wait (uint32_t ticks) ;
     extern int32_t      os_thread_notify (p_thread_t* thread, int32_t msg) ;
     extern int32_t      os_thread_notify_isr (p_thread_t* thread, int32_t msg) ;
+    /* Not on ChibiOS, give and bits return E_NOIMPL and take returns 0. */
+    extern int32_t      os_thread_notify_give (p_thread_t* thread) ;
+    extern int32_t      os_thread_notify_bits (p_thread_t* thread, uint32_t bits) ;
+    extern uint32_t     os_thread_notify_take (uint32_t clear, uint32_t ticks) ;
+    extern void         os_thread_notify_clear (void) ;
 
 #if CFG_OS_STATIC_DECLARATIONS
     extern int32_t      os_mutex_init (p_mutex_t* mutex) ;
@@ -206,6 +277,9 @@ extern "C" {
     extern int32_t      os_mutex_lock (p_mutex_t* mutex) ;
     extern void         os_mutex_unlock (p_mutex_t* mutex) ;
     extern int32_t      os_mutex_trylock (p_mutex_t* mutex) ;
+    extern int32_t      os_mutex_get_stats (p_mutex_t* mutex, OS_MUTEX_STATS_T * stats) ;
+    extern int32_t      os_mutex_stats (p_mutex_stats_function_t fp, void * arg) ;
+    extern void         os_mutex_reset_stats (void) ;
 
 #if CFG_OS_STATIC_DECLARATIONS
     extern int32_t      os_sem_init (p_sem_t* sem, int32_t cnt) ;
@@ -265,10 +339,43 @@ extern "C" {
     extern void         os_mlock_unlock (p_mlock_t* mlock) ;
     extern uint32_t     os_mlock_trylock (p_mlock_t* mlock) ;
 
+#if CFG_OS_STATIC_DECLARATIONS
+    extern int32_t      os_rwlock_init (p_rwlock_t* rwlock, uint32_t flags) ;
+    extern void         os_rwlock_deinit (p_rwlock_t* rwlock) ;
+#endif
+    extern int32_t      os_rwlock_create (p_rwlock_t* rwlock, uint32_t flags) ;
+    extern void         os_rwlock_delete (p_rwlock_t* rwlock) ;
+    extern void         os_rwlock_read_lock (p_rwlock_t* rwlock) ;
+    extern int32_t      os_rwlock_read_trylock (p_rwlock_t* rwlock) ;
+    extern void         os_rwlock_read_unlock (p_rwlock_t* rwlock) ;
+    extern void         os_rwlock_write_lock (p_rwlock_t* rwlock) ;
+    extern int32_t      os_rwlock_write_trylock (p_rwlock_t* rwlock) ;
+    extern void         os_rwlock_write_unlock (p_rwlock_t* rwlock) ;
+
+    extern int32_t      os_queue_create (p_queue_t* queue, uint32_t size) ;
+    extern void         os_queue_delete (p_queue_t* queue) ;
+    extern int32_t      os_queue_put (p_queue_t* queue, void * item, uint32_t ticks) ;
+    extern int32_t      os_queue_get (p_queue_t* queue, void ** item, uint32_t ticks) ;
+    extern uint32_t     os_queue_put_batch (p_queue_t* queue, void * const * items, uint32_t count, uint32_t ticks) ;
+    extern uint32_t     os_queue_get_batch (p_queue_t* queue, void ** items, uint32_t count, uint32_t ticks) ;
+    extern uint32_t     os_queue_count (p_queue_t* queue) ;
+
 #ifdef __cplusplus
 }
 #endif
 
+#if !defined(__GNUC__) && !defined(__clang__)
+static inline uint32_t
+os_sys_atomic_add (volatile uint32_t * ptr, uint32_t val)
+{
+    uint32_t res ;
+    os_sys_lock () ;
+    res = (*ptr += val) ;
+    os_sys_unlock () ;
+    return res ;
+}
+#endif
+
 #endif /* __OS_H__ */
 
 /** @} */
\ No newline at end of file
@@ -77,7 +77,7 @@ typedef StaticTimer_t               os_timer_t ;
                                     {0} ; \
                                     p_timer_t htimer = (p_timer_t) &__timer_##htimer ;
 
-#define OS_THREAD_WA_SIZE(stack_size) (sizeof(StaticTask_t) + 6*sizeof(uint32_t) + stack_size)
+#define OS_THREAD_WA_SIZE(stack_size) (sizeof(StaticTask_t) + 7*sizeof(uint32_t) + stack_size)
 #define OS_THREAD_WORKING_AREA(s, n)  uint64_t s[OS_THREAD_WA_SIZE(n) / sizeof (uint64_t)]
 
 
@@ -154,6 +154,7 @@ struct os_zephyr_thread {
     uint32_t            tls_values[4];
     uint32_t            tls_bitmap;
     int32_t             notify_value;
+    atomic_t            notify_bits;
     k_thread_stack_t *  stack_mem;
     size_t              stack_size;
     atomic_t            terminated;
@@ -177,14 +178,44 @@ typedef struct os_zephyr_thread    os_thread_static_t ;
 #include <semaphore.h>
 #include <time.h>
 
-typedef pthread_mutex_t             os_mutex_t ;
-#define OS_MUTEX_DECL(hmtx)         pthread_mutex_t __mtx_##hmtx = PTHREAD_MUTEX_INITIALIZER ; \
+/*
+ * Declared mutexes are named after their handle. os_mutex_init() adds a
+ * mutex to the list walked by os_mutex_stats().
+ */
+typedef struct os_mutex_s {
+    pthread_mutex_t             mutex ;
+    const char *                name ;
+    struct os_mutex_s *         next ;
+    OS_MUTEX_STATS_T            stats ;
+} os_mutex_t ;
+#define OS_MUTEX_DECL(hmtx)         os_mutex_t __mtx_##hmtx = {.mutex = PTHREAD_MUTEX_INITIALIZER, .name = #hmtx} ; \
                                                                         static p_mutex_t hmtx = (p_mutex_t) &__mtx_##hmtx ;
 typedef sem_t                       os_sem_t ;
 #define OS_SEMAPHORE_DECL(hsem)     sem_t __sem_##hsem = \
                                     {0} ; \
                                     p_sem_t hsem = (p_sem_t) &__sem_##hsem ;
 
+/*
+ * On Linux the event flags word is itself the futex. Waiters sleep on it
+ * with their mask as the futex bitset, so a signal only wakes the waiters
+ * interested in one of the signalled bits, and no system call is made
+ * while nobody waits. Define CFG_OS_POSIX_EVENT_CONDVAR for the portable
+ * mutex and condition variable implementation.
+ */
+#if defined __linux__ && !defined CFG_OS_POSIX_EVENT_CONDVAR
+#define OS_POSIX_EVENT_FUTEX        1
+
+typedef struct os_event_s {
+    uint32_t flags;
+    uint32_t waiters;
+} os_event_t ;
+
+#define OS_EVENT_DECL(hevent)       os_event_t __event_##hevent = \
+                                    {0} ; \
+                                    p_event_t hevent = (p_event_t) &__event_##hevent ;
+#else
+#define OS_POSIX_EVENT_FUTEX        0
+
 // Event structure definition
 typedef struct os_event_s {
     pthread_cond_t cond;
@@ -195,6 +226,7 @@ typedef struct os_event_s {
 #define OS_EVENT_DECL(hevent)       os_event_t __event_##hevent = \
                                     {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER} ; \
                                     p_event_t hevent = (p_event_t) &__event_##hevent ;
+#endif
 
 
 // Timer structure
@@ -239,6 +271,21 @@ typedef MLock                       os_mlock_t ;
 #define OS_MLOCK_DECL(hmlock)       os_mlock_t __mlock##hmlock = {0} ; \
                                     p_mlock_t hmlock = (p_mlock_t) &__mlock##hmlock ;
 
+/*
+ * active counts the readers holding the lock, or is -1 for a writer.
+ */
+typedef struct os_rwlock_s {
+    os_sem_t            read_sem ;
+    os_sem_t            write_sem ;
+    int32_t             active ;
+    uint16_t            readers_waiting ;
+    uint16_t            writers_waiting ;
+    uint32_t            flags ;
+} os_rwlock_t ;
+
+#define OS_RWLOCK_DECL(hrwlock)     os_rwlock_t __rwlock##hrwlock = {0} ; \
+                                    p_rwlock_t hrwlock = (p_rwlock_t) &__rwlock##hrwlock ;
+
 
 #endif
 
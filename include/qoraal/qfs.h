@@ -73,6 +73,9 @@ int  qfs_make_abs(char *out, size_t out_sz, const char *path_in);
 int qfs_unlink(const char *path);     // 0 on success, <0 on error
 int qfs_rmdir (const char *path);     // 0 on success, <0 on error (optional; for empty dirs)
 
+// Rename a file, replacing 'to' if it exists. 0 on success, <0 on error.
+int qfs_rename(const char *from, const char *to);
+
 // Simple portable wildcard match supporting '*' and '?'.
 // Returns: 1 = match, 0 = no match.
 int qfs_match(const char *pattern, const char *name);
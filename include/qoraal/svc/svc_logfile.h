@@ -0,0 +1,120 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+
+#ifndef __SVC_LOGFILE_H__
+#define __SVC_LOGFILE_H__
+
+#include <stdint.h>
+#include "qoraal/os.h"
+#include "qoraal/svc/svc_logger.h"
+#include "qoraal/svc/svc_threads.h"
+
+/*===========================================================================*/
+/* Client pre-compile time settings.                                         */
+/*===========================================================================*/
+
+#ifndef SVC_LOGFILE_BUFFER_SIZE
+#define SVC_LOGFILE_BUFFER_SIZE                     (8*1024)
+#endif
+#ifndef SVC_LOGFILE_BLOCK_SIZE
+#define SVC_LOGFILE_BLOCK_SIZE                      (2*1024)
+#endif
+#ifndef SVC_LOGFILE_FLUSH_MS
+#define SVC_LOGFILE_FLUSH_MS                        2000
+#endif
+#ifndef SVC_LOGFILE_STACK_SIZE
+#define SVC_LOGFILE_STACK_SIZE                      2048
+#endif
+#ifndef SVC_LOGFILE_PRIO
+#define SVC_LOGFILE_PRIO                            OS_THREAD_PRIO_1
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/*
+ * Zero fields take the defaults above. With max_size 0 the file is never
+ * rotated. Otherwise it is renamed to path.1, and path.1 to path.2, up to
+ * max_files, once writing the next block would take it past max_size.
+ * With max_files set every start begins a new file, with max_files 0 the
+ * file is appended to and deleted instead of renamed when it gets too big.
+ * Messages of flush_severity or more severe are written out right away,
+ * others when a block fills up or after flush_ms.
+ */
+typedef struct SVC_LOGFILE_CFG_S {
+    const char *                path ;
+    uint32_t                    buffer_size ;
+    uint32_t                    block_size ;
+    uint32_t                    max_size ;
+    uint16_t                    max_files ;
+    uint16_t                    flush_ms ;
+    uint8_t                     flush_severity ;
+} SVC_LOGFILE_CFG_T ;
+
+typedef struct SVC_LOGFILE_STATS_S {
+    uint32_t                    written ;       /**< bytes written to the file */
+    uint32_t                    dropped ;       /**< messages lost with the buffer full */
+    uint32_t                    rotations ;
+    uint32_t                    errors ;        /**< failed opens and writes */
+} SVC_LOGFILE_STATS_T ;
+
+/*
+ * The logger channel only copies into buffer, a writer thread moves whole
+ * blocks from it to the file. Caller allocated and zeroed, do not touch
+ * while started.
+ */
+typedef struct SVC_LOGFILE_S {
+    LOGGER_CHANNEL_T            channel ;
+    SVC_LOGFILE_CFG_T           cfg ;
+    SVC_THREADS_T               thread ;
+    p_sem_t                     sem ;
+    p_sem_t                     stopped ;
+    char *                      buffer ;
+    uint32_t                    head ;
+    uint32_t                    count ;
+    uint32_t                    file_size ;
+    volatile uint8_t            urgent ;
+    volatile uint8_t            stop ;
+    SVC_LOGFILE_STATS_T         stats ;
+} SVC_LOGFILE_T ;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern int32_t          svc_logfile_start (SVC_LOGFILE_T * logfile, const SVC_LOGFILE_CFG_T * cfg, LOGGGER_CHANNEL_FILTER_T filter) ;
+    extern void             svc_logfile_stop (SVC_LOGFILE_T * logfile) ;
+    extern void             svc_logfile_flush (SVC_LOGFILE_T * logfile) ;
+    extern void             svc_logfile_get_stats (SVC_LOGFILE_T * logfile, SVC_LOGFILE_STATS_T * stats) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SVC_LOGFILE_H__ */
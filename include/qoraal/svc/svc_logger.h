@@ -28,6 +28,8 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include "qoraal/svc/svc_tasks.h"
+#include "qoraal/common/logrec.h"
+#include "qoraal/common/lathist.h"
 
 /*===========================================================================*/
 /* Client pre-compile time settings.                                         */
@@ -42,6 +44,30 @@
 #ifndef SVC_LOGGER_MAX_QUEUE_SIZE
 #define SVC_LOGGER_MAX_QUEUE_SIZE                   16
 #endif
+#ifndef SVC_LOGGER_RESERVED_ERROR
+#define SVC_LOGGER_RESERVED_ERROR                   4       /**< queue entries only ERROR and ASSERT may take */
+#endif
+#ifndef SVC_LOGGER_RESERVED_WARNING
+#define SVC_LOGGER_RESERVED_WARNING                 4       /**< further entries WARNING and REPORT may take too */
+#endif
+#ifndef SVC_LOGGER_FORMAT_BUFFER_SIZE
+#define SVC_LOGGER_FORMAT_BUFFER_SIZE               256
+#endif
+#ifndef SVC_LOGGER_FORMAT_BUFFER_CNT
+#define SVC_LOGGER_FORMAT_BUFFER_CNT                2
+#endif
+#ifndef SVC_LOGGER_MEM_CHUNK_SIZE
+#define SVC_LOGGER_MEM_CHUNK_SIZE                   1024    /**< largest message a memory dump is split into */
+#endif
+#ifndef SVC_LOGGER_DEDUP_WINDOW_MS
+#define SVC_LOGGER_DEDUP_WINDOW_MS                  5000    /**< 0 disables deduplication */
+#endif
+#ifndef SVC_LOGGER_RATELIMIT_INTERVAL_MS
+#define SVC_LOGGER_RATELIMIT_INTERVAL_MS            1000
+#endif
+#ifndef SVC_LOGGER_RATELIMIT_BURST
+#define SVC_LOGGER_RATELIMIT_BURST                  5
+#endif
 
 
 /*===========================================================================*/
@@ -92,6 +118,17 @@
  */
 #define SVC_LOGGER_FILTER_CNT                       2
 
+#define SVC_LOGGER_FACILITY_CNT                     64
+
+/*
+ * Inline check against the highest severity any channel, or memory logging,
+ * accepts for the facility. Lets callers skip argument evaluation for
+ * messages that would be filtered anyway.
+ */
+#define SVC_LOGGER_ENABLED(type, facility)          \
+                        (SVC_LOGGER_GET_SEVERITY(type) <= \
+                        svc_logger_gate[(facility) & (SVC_LOGGER_FACILITY_CNT-1)])
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -100,6 +137,8 @@ typedef uint64_t    LOGGERT_MASK_T ;
 typedef uint8_t     LOGGER_TYPE_T ;
 
 typedef void (*LOGGER_CHANNEL_FP)(void* channel, LOGGER_TYPE_T /*type*/, uint8_t /*facility*/, const char* /*msg*/) ;
+typedef void (*LOGGER_CHANNEL_RECORD_FP)(void* channel, LOGGER_TYPE_T /*type*/, uint8_t /*facility*/, const char* /*msg*/,
+                    const uint8_t* /*record*/, uint32_t /*len*/) ;
 
 #pragma pack(1)
 typedef struct LOGGGER_CHANNEL_FILTER_S {
@@ -108,13 +147,74 @@ typedef struct LOGGGER_CHANNEL_FILTER_S {
 } LOGGGER_CHANNEL_FILTER_T ;
 #pragma pack()
 
+typedef enum LOGGER_OVERFLOW_E {
+    SVC_LOGGER_OVERFLOW_DROP_NEWEST = 0,
+    SVC_LOGGER_OVERFLOW_DROP_OLDEST
+} LOGGER_OVERFLOW_T ;
+
+typedef struct SVC_LOGGER_STATS_S {
+    uint32_t                    formatted ;
+    uint32_t                    truncated ;     /**< longer than SVC_LOGGER_FORMAT_BUFFER_SIZE */
+    uint32_t                    scratch_busy ;  /**< formatted without a scratch buffer */
+    uint32_t                    deduplicated ;  /**< repeats folded into a "repeated" line */
+    uint32_t                    ratelimited ;   /**< suppressed by a call site rate limit */
+    uint32_t                    enqueued ;      /**< scheduled on the logger task queue */
+    uint32_t                    dropped ;       /**< lost with the queue full or out of memory */
+    uint32_t                    high_water ;    /**< most queued, of SVC_LOGGER_MAX_QUEUE_SIZE */
+} SVC_LOGGER_STATS_T ;
+
+/*
+ * Kept in the channel. Latency is from the message being logged to the
+ * channel callback returning.
+ */
+typedef struct SVC_LOGGER_CHANNEL_STATS_S {
+    uint32_t                    delivered ;
+    uint32_t                    dropped ;       /**< lost to the channel queue overflow */
+    uint32_t                    high_water ;    /**< most queued, of queue_size */
+    LATHIST_T                   latency ;
+} SVC_LOGGER_CHANNEL_STATS_T ;
+
+/*
+ * Call site rate limit state, see SVC_LOGGER_RATELIMIT_DECL. Passes
+ * SVC_LOGGER_RATELIMIT_BURST messages every SVC_LOGGER_RATELIMIT_INTERVAL_MS
+ * and counts the rest.
+ */
+typedef struct SVC_LOGGER_RATELIMIT_S {
+    uint32_t                    start ;         /**< os_sys_timestamp() the interval started */
+    uint16_t                    count ;
+    uint16_t                    suppressed ;
+} SVC_LOGGER_RATELIMIT_T ;
+
+#define SVC_LOGGER_RATELIMIT_DECL(name)     SVC_LOGGER_RATELIMIT_T name = {0, 0, 0}
+
+struct LOGGER_CHANNEL_QUEUE_S ;
+
+/*
+ * With queue_size 0 the channel is called from the logger task, in turn with
+ * all other channels. Otherwise the channel gets its own queue of queue_size
+ * entries, drained by its own task on svc_tasks queue prio, and overflow
+ * decides which entry is lost when the channel falls behind.
+ *
+ * A channel with a record callback gets the binary record of structured
+ * messages (logrec.h) as is, with len 0 for plain messages, and fp is not
+ * used.
+ */
 typedef struct LOGGER_CHANNEL_S {
     struct LOGGER_CHANNEL_S *   next ;
     LOGGER_CHANNEL_FP           fp ;
     LOGGGER_CHANNEL_FILTER_T    filter[SVC_LOGGER_FILTER_CNT] ;
     void*                       user ;
+    uint16_t                    queue_size ;
+    uint8_t                     overflow ;
+    uint8_t                     prio ;
+    struct LOGGER_CHANNEL_QUEUE_S * queue ;
+    LOGGER_CHANNEL_RECORD_FP    record ;
+    const char *                name ;          /**< optional, for statistics */
+    SVC_LOGGER_CHANNEL_STATS_T  stats ;
 } LOGGER_CHANNEL_T ;
 
+typedef void (*SVC_LOGGER_CHANNEL_STATS_CB)(void* arg, const LOGGER_CHANNEL_T* channel, const SVC_LOGGER_CHANNEL_STATS_T* stats) ;
+
 
 
 /*===========================================================================*/
@@ -125,12 +225,16 @@ typedef struct LOGGER_CHANNEL_S {
 extern "C" {
 #endif
 
+    extern const uint8_t * volatile svc_logger_gate ;
+
     extern int32_t          svc_logger_init (SVC_TASK_PRIO_T  prio) ;
     extern int32_t          svc_logger_start (void) ;
 
     extern uint32_t         svc_logger_would_log (LOGGER_TYPE_T type, uint8_t facility) ;
     extern int32_t          svc_logger_type_log (LOGGER_TYPE_T type, uint8_t facility, const char *str, ...) ;
     extern int32_t          svc_logger_type_vlog (LOGGER_TYPE_T type, uint8_t facility, const char *format_str, va_list args) ;
+    extern int32_t          svc_logger_type_record (LOGGER_TYPE_T type, uint8_t facility, const LOGREC_FIELD_T * fields, uint32_t count, const char *format_str, ...) ;
+    extern int32_t          svc_logger_type_vrecord (LOGGER_TYPE_T type, uint8_t facility, const LOGREC_FIELD_T * fields, uint32_t count, const char *format_str, va_list args) ;
     extern int32_t          svc_logger_type_mem (LOGGER_TYPE_T type, uint8_t facility, const char* mem, uint32_t size, const char * head, const char * tail) ;
     
     extern int32_t          svc_logger_printf (const char *format_str, ...) ;
@@ -142,9 +246,14 @@ extern "C" {
 
     extern void             svc_logger_channel_add (LOGGER_CHANNEL_T * channel) ;
     extern void             svc_logger_channel_remove (LOGGER_CHANNEL_T * channel) ;
+    extern void             svc_logger_channel_set_filter (LOGGER_CHANNEL_T * channel, uint32_t idx, LOGGGER_CHANNEL_FILTER_T filter) ;
 
     extern int32_t          svc_logger_wait (uint32_t timeout) ;
     extern int32_t          svc_logger_wait_all (uint32_t timeout) ;
+    extern void             svc_logger_get_stats (SVC_LOGGER_STATS_T * stats) ;
+    extern void             svc_logger_channel_stats (SVC_LOGGER_CHANNEL_STATS_CB cb, void* arg) ;
+    extern void             svc_logger_reset_stats (void) ;
+    extern uint32_t         svc_logger_ratelimit (SVC_LOGGER_RATELIMIT_T * ratelimit, LOGGER_TYPE_T type, uint8_t facility) ;
 
     extern const char *     svs_logger_severity_str (LOGGER_TYPE_T type) ;
 
@@ -28,6 +28,7 @@
 #include "qoraal/common/rtclib.h"
 #include "qoraal/svc/svc_services.h"
 #include "qoraal/svc/svc_tasks.h"
+#include "qoraal/common/lathist.h"
 
 #define DBG_MESSAGE_SVC_MESSAGE(severity, fmt_str, ...)    DBG_MESSAGE_T_REPORT (SVC_LOGGER_TYPE(severity,0), 0, fmt_str, ##__VA_ARGS__)
 #define DBG_ASSERT_SVC_MESSAGE                             DBG_ASSERT_T
@@ -36,6 +37,10 @@
 #define SVC_MESSAGE_MAX_QUEUE_SIZE                    32
 #endif
 
+#ifndef SVC_MESSAGE_BATCH_SIZE
+#define SVC_MESSAGE_BATCH_SIZE                        16
+#endif
+
 #define SVC_MESSAGE_FILTER_CNT                        2
 
 typedef uint64_t    SVC_MESSAGE_MASK_T ;
@@ -49,27 +54,70 @@ struct SVC_MESSAGE_S;
 typedef struct SVC_MESSAGE_S SVC_MESSAGE_T ;
 
 typedef void (*SVC_MESSAGE_CHANNEL_FP)(void * channel, const SVC_MESSAGE_T * message) ;
+typedef void (*SVC_MESSAGE_CHANNEL_BATCH_FP)(void * channel, const SVC_MESSAGE_T * const * messages, uint32_t count) ;
 
 typedef struct SVC_MESSAGE_FILTER_S {
     SVC_MESSAGE_MASK_T        mask ;
 } SVC_MESSAGE_FILTER_T ;
 
+typedef enum SVC_MESSAGE_POLICY_E {
+    SVC_MESSAGE_POLICY_DROP_NEWEST = 0,     /**< reject the message being posted (E_TIMEOUT) */
+    SVC_MESSAGE_POLICY_BLOCK,               /**< wait up to the producer timeout for space */
+    SVC_MESSAGE_POLICY_DROP_OLDEST,         /**< discard the producer's oldest queued message */
+    SVC_MESSAGE_POLICY_DROP_LOWEST_PRIO     /**< discard the producer's lowest priority message */
+} SVC_MESSAGE_POLICY_T ;
+
+typedef struct SVC_MESSAGE_STATS_S {
+    uint32_t                 posted ;
+    uint32_t                 dropped ;
+    uint32_t                 queued ;
+    uint32_t                 high_water ;
+    uint32_t                 delivered ;    /**< dispatched to the channels */
+} SVC_MESSAGE_STATS_T ;
+
+/*
+ * Kept in the channel. Latency is from svc_message_create() to the message
+ * being dispatched to the channel.
+ */
+typedef struct SVC_MESSAGE_CHANNEL_STATS_S {
+    uint32_t                 delivered ;
+    LATHIST_T                latency ;
+} SVC_MESSAGE_CHANNEL_STATS_T ;
+
+/**
+ * Optional queue limit for the messages of one module. Registered with
+ * svc_message_producer_add(), the policy decides what happens when either
+ * this limit or SVC_MESSAGE_MAX_QUEUE_SIZE is reached.
+ */
+typedef struct SVC_MESSAGE_PRODUCER_S {
+    struct SVC_MESSAGE_PRODUCER_S * next ;
+    int32_t                  module ;
+    uint32_t                 limit ;        /**< 0 for only the global limit */
+    SVC_MESSAGE_POLICY_T     policy ;
+    uint32_t                 timeout ;      /**< ms, SVC_MESSAGE_POLICY_BLOCK only */
+    SVC_MESSAGE_STATS_T      stats ;
+} SVC_MESSAGE_PRODUCER_T ;
+
 typedef struct SVC_MESSAGE_CHANNEL_S {
     struct SVC_MESSAGE_CHANNEL_S * next ;
     SVC_MESSAGE_CHANNEL_FP         fp ;
     SVC_MESSAGE_FILTER_T           filter[SVC_MESSAGE_FILTER_CNT] ;
     void *                       user ;
+    SVC_MESSAGE_CHANNEL_BATCH_FP   batch ;     /**< optional, preferred over fp when set */
+    const char *                   name ;      /**< optional, for statistics */
+    SVC_MESSAGE_CHANNEL_STATS_T    stats ;
 } SVC_MESSAGE_CHANNEL_T ;
 
+typedef void (*SVC_MESSAGE_CHANNEL_STATS_CB)(void * arg, const SVC_MESSAGE_CHANNEL_T * channel, const SVC_MESSAGE_CHANNEL_STATS_T * stats) ;
+
 struct SVC_MESSAGE_S {
-    SVC_TASKS_T              task ;
+    struct SVC_MESSAGE_S *   next ;
     uint32_t                 id ;
     uint32_t                 type ;
     int32_t                  module ;
     uint32_t                 size ;
-    uint64_t                 timestamp_ms ;
-    RTCLIB_DATE_T            date ;
-    RTCLIB_TIME_T            time ;
+    uint32_t                 prio ;         /**< higher survives SVC_MESSAGE_POLICY_DROP_LOWEST_PRIO */
+    uint64_t                 timestamp ;    /**< os_sys_ns_timestamp(), see rtc_localtime_ns() */
     uint8_t                  payload[] ;
 } ;
 
@@ -86,12 +134,20 @@ extern "C" {
     extern uint32_t         svc_message_would_post (int32_t module) ;
     extern SVC_MESSAGE_T *  svc_message_create (uint32_t size, uint32_t type, int32_t module) ;
     extern int32_t          svc_message_post (SVC_MESSAGE_T * message) ;
+    extern int32_t          svc_message_post_batch (SVC_MESSAGE_T ** messages, uint32_t count) ;
+
+    extern void             svc_message_producer_add (SVC_MESSAGE_PRODUCER_T * producer) ;
+    extern void             svc_message_producer_remove (SVC_MESSAGE_PRODUCER_T * producer) ;
+    extern void             svc_message_get_stats (SVC_MESSAGE_STATS_T * stats) ;
+    extern void             svc_message_reset_stats (void) ;
+    extern void             svc_message_channel_stats (SVC_MESSAGE_CHANNEL_STATS_CB cb, void * arg) ;
 
     extern void             svc_message_channel_add (SVC_MESSAGE_CHANNEL_T * channel) ;
     extern void             svc_message_channel_remove (SVC_MESSAGE_CHANNEL_T * channel) ;
 
     extern int32_t          svc_message_wait (uint32_t timeout) ;
     extern int32_t          svc_message_wait_all (uint32_t timeout) ;
+    extern int32_t          svc_message_channel_flush (SVC_MESSAGE_CHANNEL_T * channel, uint32_t timeout) ;
 
     extern SVC_MESSAGE_FILTER_T svc_message_get_filter (void) ;
 
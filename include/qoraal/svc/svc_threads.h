@@ -36,6 +36,16 @@
 #define DBG_MESSAGE_SVC_THREADS(severity, fmt_str, ...)    DBG_MESSAGE_T_LOG (SVC_LOGGER_TYPE(severity,0), 0, fmt_str, ##__VA_ARGS__)
 #define DBG_ASSERT_SVC_THREADS                               DBG_ASSERT_T
 
+/*
+ * Number of finished threads kept parked, with their stacks, to run later
+ * svc_threads_create() calls with the same stack size and priority. With 0
+ * every svc_threads_create() creates a new OS thread that is joined when it
+ * completes.
+ */
+#ifndef SVC_THREADS_POOL_SIZE
+#define SVC_THREADS_POOL_SIZE                               0
+#endif
+
 /*===========================================================================*/
 /* Module constants.                                                         */
 /*===========================================================================*/
@@ -50,13 +60,18 @@ typedef void (*SVC_THREADS_COMPLETE_CALLBACK_T)(struct SVC_THREADS_S * /*service
 
 typedef struct SVC_THREADS_S {
     struct SVC_THREADS_S *          next ;
+    struct SVC_THREADS_S *          prev ;
     p_thread_t                      thread ;
     p_thread_function_t             pf ;        
     void*                           arg ;
     SVC_THREADS_COMPLETE_CALLBACK_T complete ;
+    struct SVC_THREADS_WORKER_S *   worker ;    /**< pooled thread to join, 0 if it was parked */
+    const char *                    name ;
 } SVC_THREADS_T;
 
-#define _SVC_THREADS_DATA/*(name)*/    {0,0,0,0,0}
+typedef void (*SVC_THREADS_ENUM_CALLBACK_T)(void* /*arg*/, SVC_THREADS_T * /*service_thread*/) ;
+
+#define _SVC_THREADS_DATA/*(name)*/    {0,0,0,0,0,0,0,0}
 #define SVC_THREADS_DECL(name)   SVC_THREADS_T name =  _SVC_THREADS_DATA/*(name)*/ 
 
 /*===========================================================================*/
@@ -75,6 +90,8 @@ extern "C" {
                             void *arg, const char* name) ;
 
     bool            svc_threads_is_active (SVC_THREADS_T* service_thread) ;
+    SVC_THREADS_T*  svc_threads_current (void) ;
+    uint32_t        svc_threads_enum (SVC_THREADS_ENUM_CALLBACK_T fp, void* arg) ;
 
     uint32_t        svc_threads_count (void) ;
 
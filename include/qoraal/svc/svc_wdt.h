@@ -58,14 +58,24 @@ typedef void (*SVC_WDY_KICK_CB_T)(void) ;
 
 
 
+/*
+ * The owning thread only ever stores active, kicked and max_interval, the
+ * checker only writes flags and due, so kicks need no lock.
+ */
 typedef struct SVC_WDT_HANDLE_S {
-    struct SVC_EVENTS_HANDLER_S * next ;
+    struct SVC_WDT_HANDLE_S * volatile next ;
     p_thread_t      thread ;
     uintptr_t       id ;
     uint32_t        flags ;
-    SVC_WDT_TIMEOUTS_T timeout ;
+    uint32_t        timeout ;       /**< deadline between kicks in ms */
+    uint32_t        due ;           /**< tick of the next check */
+    uint32_t        active ;
+    uint32_t        kicked ;        /**< tick of the last kick */
+    uint32_t        max_interval ;  /**< longest time between kicks in ticks */
 } SVC_WDT_HANDLE_T ;
 
+typedef void (*SVC_WDT_ENUM_CALLBACK_T)(void* /*arg*/, SVC_WDT_HANDLE_T * /*handler*/) ;
+
 
 /*===========================================================================*/
 /* External declarations.                                                    */
@@ -80,8 +90,12 @@ extern "C" {
     void                    svc_wdt_stop (void) ;
 
     void                    svc_wdt_register (SVC_WDT_HANDLE_T * handler, SVC_WDT_TIMEOUTS_T id) ;
+    void                    svc_wdt_register_ms (SVC_WDT_HANDLE_T * handler, uint32_t timeout_ms) ;
     void                    svc_wdt_unregister (SVC_WDT_HANDLE_T * handler, SVC_WDT_TIMEOUTS_T id) ;
     uint32_t                svc_wdt_timeout (SVC_WDT_HANDLE_T * handler) ;
+    uint32_t                svc_wdt_timeout_ms (SVC_WDT_HANDLE_T * handler) ;
+    uint32_t                svc_wdt_max_interval (SVC_WDT_HANDLE_T * handler) ;
+    uint32_t                svc_wdt_enum (SVC_WDT_ENUM_CALLBACK_T fp, void* arg) ;
 
     void                    svc_wdt_activate (SVC_WDT_HANDLE_T * handler) ;
     void                    svc_wdt_set_id (SVC_WDT_HANDLE_T * handler, uintptr_t id) ;
@@ -0,0 +1,295 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+
+#include <string.h>
+#include "qoraal/common/logrec.h"
+
+static const char _logrec_hex[] = "0123456789abcdef" ;
+
+static uint32_t
+logrec_key_len (const LOGREC_FIELD_T * field)
+{
+    uint32_t len = field->key ? strlen (field->key) : 0 ;
+    return len > LOGREC_KEY_SIZE_MAX ? LOGREC_KEY_SIZE_MAX : len ;
+}
+
+static uint32_t
+logrec_str_len (const LOGREC_FIELD_T * field)
+{
+    uint32_t len = field->s ? strlen (field->s) : 0 ;
+    return len > LOGREC_STR_SIZE_MAX ? LOGREC_STR_SIZE_MAX : len ;
+}
+
+static uint32_t
+logrec_varint_len (uint32_t value)
+{
+    uint32_t len = 1 ;
+    while (value >= 0x80) {
+        value >>= 7 ;
+        len++ ;
+    }
+    return len ;
+}
+
+static uint32_t
+logrec_value (const LOGREC_FIELD_T * field)
+{
+    if (field->type == LOGREC_TYPE_INT) {
+        return ((uint32_t)field->i << 1) ^ (uint32_t)(field->i >> 31) ;
+    }
+    return field->u ;
+}
+
+static uint32_t
+logrec_field_size (const LOGREC_FIELD_T * field)
+{
+    uint32_t size = 2 + logrec_key_len (field) ;
+
+    if (field->type == LOGREC_TYPE_STR) {
+        size += 1 + logrec_str_len (field) ;
+    } else {
+        size += logrec_varint_len (logrec_value (field)) ;
+    }
+
+    return size ;
+}
+
+/**
+ * @brief   Bytes needed to encode the fields.
+ *
+ * @param[in] fields        fields
+ * @param[in] count         number of fields
+ *
+ * @return              record size.
+ */
+uint32_t
+logrec_size (const LOGREC_FIELD_T * fields, uint32_t count)
+{
+    uint32_t size = 0 ;
+    uint32_t i ;
+
+    for (i=0; i<count; i++) {
+        if (fields[i].type && (fields[i].type < LOGREC_TYPE_LAST)) {
+            size += logrec_field_size (&fields[i]) ;
+        }
+    }
+
+    return size ;
+}
+
+/**
+ * @brief   Encodes the fields into a binary record.
+ * @note    Fields of unknown type, or that no longer fit, are left out.
+ *          Keys and strings are cut to LOGREC_KEY_SIZE_MAX and
+ *          LOGREC_STR_SIZE_MAX.
+ *
+ * @param[out] record       record
+ * @param[in] size          size of record
+ * @param[in] fields        fields
+ * @param[in] count         number of fields
+ *
+ * @return              bytes used in record.
+ */
+uint32_t
+logrec_encode (uint8_t * record, uint32_t size, const LOGREC_FIELD_T * fields, uint32_t count)
+{
+    uint32_t len = 0 ;
+    uint32_t i ;
+
+    for (i=0; i<count; i++) {
+        const LOGREC_FIELD_T * field = &fields[i] ;
+        uint32_t key_len ;
+        uint32_t value ;
+
+        if (!field->type || (field->type >= LOGREC_TYPE_LAST) ||
+                (len + logrec_field_size (field) > size)) {
+            continue ;
+        }
+
+        key_len = logrec_key_len (field) ;
+        record[len++] = field->type ;
+        record[len++] = (uint8_t)key_len ;
+        memcpy (&record[len], field->key, key_len) ;
+        len += key_len ;
+
+        if (field->type == LOGREC_TYPE_STR) {
+            value = logrec_str_len (field) ;
+            record[len++] = (uint8_t)value ;
+            memcpy (&record[len], field->s, value) ;
+            len += value ;
+
+        } else {
+            value = logrec_value (field) ;
+            while (value >= 0x80) {
+                record[len++] = (uint8_t)(value | 0x80) ;
+                value >>= 7 ;
+            }
+            record[len++] = (uint8_t)value ;
+
+        }
+    }
+
+    return len ;
+}
+
+/**
+ * @brief   Decodes the next field of a record.
+ *
+ * @param[in] record        current position in the record
+ * @param[in] end           end of the record
+ * @param[out] field        decoded field
+ *
+ * @return              position of the next field or 0 at the end or if the
+ *                      record is corrupt.
+ */
+const uint8_t *
+logrec_decode (const uint8_t * record, const uint8_t * end, LOGREC_FIELD_T * field)
+{
+    uint32_t value = 0 ;
+    uint32_t shift = 0 ;
+
+    if (!record || (end - record < 3)) {
+        return 0 ;
+    }
+
+    field->type = *record++ ;
+    field->key_len = *record++ ;
+    if ((field->type == 0) || (field->type >= LOGREC_TYPE_LAST) ||
+            (end - record < field->key_len + 1)) {
+        return 0 ;
+    }
+    field->key = (const char *)record ;
+    record += field->key_len ;
+    field->len = 0 ;
+
+    if (field->type == LOGREC_TYPE_STR) {
+        field->len = *record++ ;
+        if (end - record < field->len) {
+            return 0 ;
+        }
+        field->s = (const char *)record ;
+        return record + field->len ;
+
+    }
+
+    do {
+        if ((record >= end) || (shift > 28)) {
+            return 0 ;
+        }
+        value |= (uint32_t)(*record & 0x7F) << shift ;
+        shift += 7 ;
+    } while (*record++ & 0x80) ;
+
+    if (field->type == LOGREC_TYPE_INT) {
+        field->i = (int32_t)((value >> 1) ^ (0 - (value & 1))) ;
+    } else {
+        field->u = value ;
+    }
+
+    return record ;
+}
+
+static uint32_t
+logrec_put (char * buffer, uint32_t len, uint32_t size, const char * str, uint32_t n)
+{
+    if (len + n >= size) {
+        n = size - len - 1 ;
+    }
+    memcpy (&buffer[len], str, n) ;
+    return len + n ;
+}
+
+/**
+ * @brief   Renders the fields of a record as " key=value" text.
+ * @note    Strings are quoted and HEX values are prefixed with 0x. Output is
+ *          cut at size and always terminated.
+ *
+ * @param[out] buffer       text
+ * @param[in] size          size of buffer
+ * @param[in] record        record
+ * @param[in] len           length of the record
+ *
+ * @return              length of the text.
+ */
+uint32_t
+logrec_render (char * buffer, uint32_t size, const uint8_t * record, uint32_t len)
+{
+    const uint8_t * end = record + len ;
+    LOGREC_FIELD_T field ;
+    uint32_t res = 0 ;
+    char digits[12] ;
+    uint32_t value ;
+    int i ;
+
+    if (!size) {
+        return 0 ;
+    }
+
+    while ((record = logrec_decode (record, end, &field)) != 0) {
+        res = logrec_put (buffer, res, size, " ", 1) ;
+        res = logrec_put (buffer, res, size, field.key, field.key_len) ;
+        res = logrec_put (buffer, res, size, "=", 1) ;
+
+        switch (field.type) {
+        case LOGREC_TYPE_STR:
+            res = logrec_put (buffer, res, size, "\"", 1) ;
+            res = logrec_put (buffer, res, size, field.s, field.len) ;
+            res = logrec_put (buffer, res, size, "\"", 1) ;
+            break ;
+
+        case LOGREC_TYPE_HEX:
+            i = sizeof(digits) ;
+            value = field.u ;
+            do {
+                digits[--i] = _logrec_hex[value & 0x0F] ;
+                value >>= 4 ;
+            } while (value) ;
+            digits[--i] = 'x' ;
+            digits[--i] = '0' ;
+            res = logrec_put (buffer, res, size, &digits[i], sizeof(digits) - i) ;
+            break ;
+
+        default:
+            i = sizeof(digits) ;
+            value = field.u ;
+            if ((field.type == LOGREC_TYPE_INT) && (field.i < 0)) {
+                value = 0 - (uint32_t)field.i ;
+            }
+            do {
+                digits[--i] = '0' + (value % 10) ;
+                value /= 10 ;
+            } while (value) ;
+            if ((field.type == LOGREC_TYPE_INT) && (field.i < 0)) {
+                digits[--i] = '-' ;
+            }
+            res = logrec_put (buffer, res, size, &digits[i], sizeof(digits) - i) ;
+            break ;
+
+        }
+    }
+
+    buffer[res] = '\0' ;
+
+    return res ;
+}
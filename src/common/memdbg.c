@@ -38,6 +38,8 @@
 /*==================================================================================================
                                      LOCAL VARIABLES
 ==================================================================================================*/
+static const char _hex_upper[] = "0123456789ABCDEF" ;
+static const char _hex_lower[] = "0123456789abcdef" ;
 
 /*==================================================================================================
 FUNCTION: get_printable          
@@ -74,6 +76,65 @@ char* dbg_format_mem_dump_buffer (char* buffer, int len, const char* data, int s
     return dbg_format_mem_dump_width (buffer, len, data, size, print_addr, DUMP_DATA_LINE_SIZE) ;
 }
 
+/*==================================================================================================
+FUNCTION: dbg_format_mem_dump_render
+DESCRIPTION:
+   renders a single dump line for up to width bytes of data into line and returns its length.
+   Line must hold DBG_MEM_DUMP_LINE_LENGTH(width) + 1 characters. Hex digits are looked up in a
+   table, no formatting calls are made.
+
+ARGUMENTS PASSED:
+RETURN VALUE:
+PRE-CONDITIONS:
+POST-CONDITIONS:
+IMPORTANT NOTES:
+==================================================================================================*/
+int dbg_format_mem_dump_render (char* line, const char* data, int size, unsigned int print_addr, int width)
+{
+    int i ;
+    int len = 0;
+
+#define PUT_LITERAL(str)    do { memcpy (&line[len], str, sizeof(str) - 1) ; len += sizeof(str) - 1 ; } while (0)
+
+#ifndef MEMDBG_MAKE_CARRAY
+    PUT_LITERAL ("    0x") ;
+    for (i=28; i>=0; i-=4) {
+        line[len++] = _hex_lower[(print_addr >> i) & 0x0F] ;
+    }
+    PUT_LITERAL (":   ") ;
+#else
+    (void)print_addr ;
+#endif
+
+    for (i=0; i<width; i++) {
+        if (i < size) {
+            PUT_LITERAL (DUMP_HEX_SEPERATOR_LEAD) ;
+            line[len++] = _hex_upper[((unsigned char)data[i]) >> 4] ;
+            line[len++] = _hex_upper[((unsigned char)data[i]) & 0x0F] ;
+            PUT_LITERAL (DUMP_HEX_SEPERATOR_TRAIL) ;
+        } else {
+#ifndef MEMDBG_MAKE_CARRAY
+            PUT_LITERAL (DUMP_HEX_SEPERATOR_LEAD) ;
+            PUT_LITERAL ("  ") ;
+            PUT_LITERAL (DUMP_HEX_SEPERATOR_TRAIL) ;
+#endif
+        }
+    }
+
+#ifndef MEMDBG_MAKE_CARRAY
+    PUT_LITERAL (ASCII_SEPERATOR) ;
+    for (i=0; i<size; i++) {
+        line[len++] = get_printable (data[i]) ;
+    }
+#endif
+    PUT_LITERAL (MEMDBG_NEWLINE) ;
+    line[len] = '\0' ;
+
+#undef PUT_LITERAL
+
+    return len ;
+}
+
 /*==================================================================================================
 FUNCTION: dbg_mem_dump          
 DESCRIPTION: 
@@ -85,66 +146,62 @@ RETURN VALUE:
 PRE-CONDITIONS:
 POST-CONDITIONS:
 IMPORTANT NOTES:
+   output stops at the last complete line that fits in buffer_len.
 ==================================================================================================*/
 char* dbg_format_mem_dump_width (char* buffer, int buffer_len, const char* data, int size, unsigned int print_addr, int width)
 {
-    int i, j ;
+    int line ;
+    int offset = 0 ;
     int len = 0;
-    int left ;
-
-#define LINE_LENGTH(w)      (18 + w * 3 + 5 + w + 2)
 
     if (buffer_len < 22 ) {
         buffer[0] = '\0' ;
         return buffer ;
     }
 
-//  len += sprintf (&buffer[len], "dumping %.4d bytes%s", size, MEMDBG_NEWLINE);
+    if ((width <= 0) || (width > DBG_MEM_DUMP_WIDTH_MAX)) {
+        width = DUMP_DATA_LINE_SIZE ;
+    }
 
-    for (j=0; ((j+1)*width) < size && (len<buffer_len-LINE_LENGTH(width)) ; j++) {
-#ifndef MEMDBG_MAKE_CARRAY
-        len += sprintf (&buffer[len], "    0x%.8x:   ", print_addr + j*width /*&data[j*width]*/);
-#endif
-        for (i=0; i<width; i++) {
-            len += sprintf (&buffer[len], "%s%.2X", DUMP_HEX_SEPERATOR_LEAD, (char)data[i+j*width]&0xFF);
-            len += sprintf (&buffer[len], "%s", DUMP_HEX_SEPERATOR_TRAIL);
+    buffer[0] = '\0' ;
+    do {
+        if (len + DBG_MEM_DUMP_LINE_LENGTH(width) >= buffer_len) {
+            break ;
         }
-#ifndef MEMDBG_MAKE_CARRAY
-        len += sprintf (&buffer[len], "%s", ASCII_SEPERATOR) ;
-        for (i=0;  i<width; i++) {
-            len += sprintf (&buffer[len], "%c", get_printable(data[i+j*width]));
-        }
-#endif
-        len += sprintf (&buffer[len], "%s", MEMDBG_NEWLINE);
-    }
+        line = (size - offset) > width ? width : size - offset ;
+        len += dbg_format_mem_dump_render (&buffer[len], &data[offset], line,
+                print_addr + offset, width) ;
+        offset += line ;
 
+    } while (offset < size) ;
 
-    if (len<(buffer_len-LINE_LENGTH(width))) {
-        left = size-j*width ;
-#ifndef MEMDBG_MAKE_CARRAY
-        len += sprintf (&buffer[len], "    0x%.8x:   ", print_addr + j*width /*&data[j*width]*/);
-#endif
+    return buffer ;
+}
 
-        for (i=0; i<width; i++) {
-            if (i < left) {
-                len += sprintf (&buffer[len], "%s%.2X", DUMP_HEX_SEPERATOR_LEAD, (char)data[i+j*width]&0xFF);
-                len += sprintf (&buffer[len], "%s", DUMP_HEX_SEPERATOR_TRAIL);
-            } else {
-#ifndef MEMDBG_MAKE_CARRAY
-                len += sprintf (&buffer[len], "%s  %s" , DUMP_HEX_SEPERATOR_LEAD,  DUMP_HEX_SEPERATOR_TRAIL);
-#endif
-            }
-        }
-#ifndef MEMDBG_MAKE_CARRAY
-        len += sprintf (&buffer[len], "%s", ASCII_SEPERATOR) ;
-        for (i=0; i<left; i++) {
-            len += sprintf (&buffer[len], "%c",  get_printable(data[i+j*width]));
-        }
-#endif
-        len += sprintf (&buffer[len], "%s", MEMDBG_NEWLINE);
+/*==================================================================================================
+FUNCTION: dbg_format_hex
+DESCRIPTION:
+   prints size bytes of data as a string of hex digits without separators and returns the number
+   of characters written. Buffer must hold size * 2 + 1 characters.
+
+ARGUMENTS PASSED:
+RETURN VALUE:
+PRE-CONDITIONS:
+POST-CONDITIONS:
+IMPORTANT NOTES:
+==================================================================================================*/
+int dbg_format_hex (char* buffer, const char* data, int size, unsigned int lower)
+{
+    const char * digits = lower ? _hex_lower : _hex_upper ;
+    int i ;
+
+    for (i=0; i<size; i++) {
+        buffer[i*2] = digits[((unsigned char)data[i]) >> 4] ;
+        buffer[i*2+1] = digits[((unsigned char)data[i]) & 0x0F] ;
     }
+    buffer[i*2] = '\0' ;
 
-    return buffer ;
+    return i*2 ;
 }
 
 /*==================================================================================================
@@ -164,20 +221,18 @@ char* dbg_format_mem_dump_line (char* buffer, int buffer_len, const char* data,
     int i  ;
     int len = 0;
 
-    for (i=0; i<size; i++) {
-        len += sprintf (&buffer[len], "%.2X ", (char)data[i]&0xFF);
-        if (len >= buffer_len-4) break ;
+    for (i=0; (i<size) && (len < buffer_len-4); i++) {
+        buffer[len++] = _hex_upper[((unsigned char)data[i]) >> 4] ;
+        buffer[len++] = _hex_upper[((unsigned char)data[i]) & 0x0F] ;
+        buffer[len++] = ' ' ;
     }
+    buffer[len] = '\0' ;
 
     return buffer ;
 }
 
 char* dbg_format_mem_2html_buffer (char* buffer, int buffer_len, const char* data, int size, unsigned int print_addr)
 {
-#undef LINE_LENGTH
-#define LINE_LENGTH(w)      (18 + w * 3 + 5 + w + 1)
-
-
     int j ;
     int len = 0 ;
     if (buffer_len < 22 ) {
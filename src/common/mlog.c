@@ -116,25 +116,20 @@ mlog_started (void)
 }
 
 static int32_t  
-_append (uint16_t type, uint16_t id, MLOG_TYPE_T log, const char* fmtstr, va_list  args)
+_store (uint16_t type, uint16_t id, MLOG_TYPE_T log, const char* text, int msglen, const uint8_t * record, uint32_t reclen)
 {
     int cnt = 10 ;
-    int msglen ;
     CBUFFER_QUEUE_T* logqueue = get_cqueue (log) ;
     if (!logqueue) {
         return E_UNEXP ;
     }
 
-    msglen = vsnprintf (_mlog_print_buffer, sizeof(_mlog_print_buffer), fmtstr, args) ;
-    if (msglen < 0) {
-        _mlog_print_buffer[0] = '\0' ;
-        msglen = 0 ;
-    } else if (msglen >= (int)sizeof(_mlog_print_buffer)) {
-        _mlog_print_buffer[sizeof(_mlog_print_buffer) - 1] = '\0' ;
-        msglen = sizeof(_mlog_print_buffer) - 1 ;
+    while (msglen &&
+        ((text[msglen-1] == '\r') || (text[msglen-1] == '\n'))) {
+            msglen-- ;
     }
 
-    int len = (sizeof(QORAAL_LOG_MSG_T) + msglen + 1 + sizeof(uint32_t)  ) / sizeof(uint32_t) ;
+    int len = (sizeof(QORAAL_LOG_MSG_T) + msglen + 1 + reclen + sizeof(uint32_t)  ) / sizeof(uint32_t) ;
     CBUFFER_ITEM_T* buffer = cqueue_enqueue (logqueue, len) ;
     while (!buffer && cqueue_dequeue (logqueue) && cnt--) {
         buffer = cqueue_enqueue (logqueue, len) ;
@@ -148,16 +143,14 @@ _append (uint16_t type, uint16_t id, MLOG_TYPE_T log, const char* fmtstr, va_lis
         msg->id = id ;
         msg->cnt = _memlog_cnt++ ;
 
-        msg->date = rtc_get_date () ;
-        msg->time = rtc_get_time () ;
-        msg->len = msglen + 1;
-        memcpy(msg->msg, _mlog_print_buffer, msg->len);
-
-        while (msglen &&
-            ((msg->msg[msglen-1] == '\r') || (msg->msg[msglen-1] == '\n'))) {
-                msg->msg[msglen-1] = '\0' ;
-                msg->len-- ;
-                msglen-- ;
+        uint64_t timestamp = rtc_epoch_ns (os_sys_ns_timestamp ()) ;
+        msg->seconds = (uint32_t)(timestamp / 1000000000ULL) ;
+        msg->nsec = (uint32_t)(timestamp % 1000000000ULL) ;
+        msg->len = msglen + 1 + reclen ;
+        memcpy(msg->msg, text, msglen);
+        msg->msg[msglen] = '\0' ;
+        if (reclen) {
+            memcpy(&msg->msg[msglen + 1], record, reclen);
         }
 
         cqueue_flush_item (logqueue, buffer) ;
@@ -167,6 +160,23 @@ _append (uint16_t type, uint16_t id, MLOG_TYPE_T log, const char* fmtstr, va_lis
     return EOK ;
 }
 
+static int32_t  
+_append (uint16_t type, uint16_t id, MLOG_TYPE_T log, const char* fmtstr, va_list  args)
+{
+    int msglen ;
+
+    msglen = vsnprintf (_mlog_print_buffer, sizeof(_mlog_print_buffer), fmtstr, args) ;
+    if (msglen < 0) {
+        _mlog_print_buffer[0] = '\0' ;
+        msglen = 0 ;
+    } else if (msglen >= (int)sizeof(_mlog_print_buffer)) {
+        _mlog_print_buffer[sizeof(_mlog_print_buffer) - 1] = '\0' ;
+        msglen = sizeof(_mlog_print_buffer) - 1 ;
+    }
+
+    return _store (type, id, log, _mlog_print_buffer, msglen, 0, 0) ;
+}
+
 static int32_t  
 mlog_append (uint16_t type, uint16_t id, MLOG_TYPE_T log, const char* msg, va_list args)
 {
@@ -242,6 +252,36 @@ mlog_log (int16_t facillity,  int16_t severity, const char* msg, ...)
     return res ;
 }
 
+/**
+ * @brief   Logs a message with its structured record, see logrec.h.
+ * @note    The message is stored as is, not used as a format string. The
+ *          record is stored after the message terminator and counted in len.
+ */
+int32_t
+mlog_record (int16_t facillity,  int16_t severity, const char* msg, const uint8_t * record, uint32_t len)
+{
+    union {
+    uint16_t        type ;
+    struct {
+        uint8_t     severity ;
+        uint8_t     facillity ;
+    } ;
+    } logtype ;
+    logtype.facillity = facillity ;
+    logtype.severity = severity ;
+
+    uint32_t msglen = strlen (msg) ;
+    if (msglen >= MLOG_LOGS_MSG_SIZE_MAX) {
+        msglen = MLOG_LOGS_MSG_SIZE_MAX - 1 ;
+    }
+
+    if (!_memlog_started)  return E_UNEXP ;
+    os_mutex_lock (&_mlog_mutex) ;
+    int32_t res = _store (logtype.type, 0, MLOG_DBG, msg, msglen, record, len) ;
+    os_mutex_unlock (&_mlog_mutex) ;
+    return res ;
+}
+
 int32_t 
 mlog_assert (const char* msg, ...)
 {
@@ -474,12 +514,14 @@ _it_get(struct QORAAL_LOG_IT_S * it, QORAAL_LOG_MSG_T * msg, uint32_t len)
     _MEMLOG_IT_T *syslogit = (_MEMLOG_IT_T*) it ;
     QORAAL_LOG_MSG_T*  m = mlog_itertor_get (syslogit->log, syslogit->it) ;
     if (m) {
+        uint32_t end = len - sizeof(QORAAL_LOG_MSG_T) - 1 ;
         if (len > sizeof(QORAAL_LOG_MSG_T) + m->len) {
             len = sizeof(QORAAL_LOG_MSG_T) + m->len ;
+            end = m->len ;
         }
         memcpy (msg, m, len) ;
         mlog_itertor_release (syslogit->log, syslogit->it) ;
-        msg->msg[m->len] = '\0' ;
+        msg->msg[end] = '\0' ;
         res = (int32_t) len ;
 
     }
@@ -24,6 +24,11 @@
 
 #include "qoraal/qoraal.h"
 #include "qoraal/common/rtclib.h"
+#include "qoraal/os.h"
+
+static uint64_t     _rtc_anchor_ns = 0 ;
+static uint64_t     _rtc_anchor_checked = 0 ;
+static uint32_t     _rtc_anchor_valid = 0 ;
 
 
 RTCLIB_TIME_T
@@ -60,6 +65,53 @@ rtc_localtime (uint32_t timestamp, RTCLIB_DATE_T* date, RTCLIB_TIME_T* time)
     }
 }
 
+/**
+ * @brief   Converts a monotonic os_sys_ns_timestamp() value to nanoseconds
+ *          since the epoch.
+ * @details The offset between the monotonic clock and qoraal_current_time()
+ *          is cached and only re-evaluated every RTCLIB_ANCHOR_CHECK_NS, so
+ *          the conversion is an addition in the common case. The anchor
+ *          moves only if the wall clock was set, not for sub-second jitter.
+ */
+uint64_t
+rtc_epoch_ns (uint64_t timestamp_ns)
+{
+    uint64_t now = os_sys_ns_timestamp () ;
+    uint64_t anchor ;
+
+    if (!_rtc_anchor_valid ||
+            (now - _rtc_anchor_checked >= RTCLIB_ANCHOR_CHECK_NS)) {
+        uint64_t wall = (uint64_t)qoraal_current_time () * 1000000000ULL ;
+        uint64_t estimate = _rtc_anchor_ns + now ;
+
+        os_sys_lock () ;
+        if (!_rtc_anchor_valid ||
+                (estimate + 1000000000ULL < wall) ||
+                (estimate > wall + 2000000000ULL)) {
+            _rtc_anchor_ns = wall - now ;
+            _rtc_anchor_valid = 1 ;
+        }
+        _rtc_anchor_checked = now ;
+        os_sys_unlock () ;
+    }
+
+    os_sys_lock () ;
+    anchor = _rtc_anchor_ns ;
+    os_sys_unlock () ;
+
+    return anchor + timestamp_ns ;
+}
+
+/**
+ * @brief   Calendar date and time for a monotonic os_sys_ns_timestamp()
+ *          value, see rtc_epoch_ns().
+ */
+void
+rtc_localtime_ns (uint64_t timestamp_ns, RTCLIB_DATE_T* date, RTCLIB_TIME_T* time)
+{
+    rtc_localtime ((uint32_t)(rtc_epoch_ns (timestamp_ns) / 1000000000ULL), date, time) ;
+}
+
 uint32_t
 rtc_mktime (RTCLIB_DATE_T date, RTCLIB_TIME_T time)        /* convert date to day number */
 {
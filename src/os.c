@@ -42,6 +42,9 @@
 #endif
 #if defined CFG_OS_THREADX && CFG_OS_THREADX
 #include "tx_api.h"
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+#include "tx_execution_profile.h"
+#endif
 #ifndef TX_DISABLE_ERROR_CHECKING
 #define TX_ASSERT(x, v)   DBG_ASSERT_T(x == v, "TXASSERT")
 #else 
@@ -63,6 +66,14 @@
  * Static global variables.
  */
 #define MAX_TLS_ID      4
+
+/*
+ * Frequency of the FreeRTOS run time stats counter or of the ThreadX
+ * execution profile timer.
+ */
+#ifndef OS_RUNTIME_COUNTER_HZ
+#define OS_RUNTIME_COUNTER_HZ       1000000
+#endif
 static  uint8_t         _os_tls_values[MAX_TLS_ID] = {0};
 static  int             _os_started = 0 ;
 
@@ -77,6 +88,7 @@ typedef struct OS_THREAD_WA_S {
     StaticQueue_t               join_sem ;
     int32_t                     suspend_msg ;
     int32_t                     errorno ;
+    uint32_t                    stack_size ;
     void *                      arg ;
     p_thread_function_t         pf ;
     StackType_t                 stack[0] ;
@@ -114,6 +126,7 @@ typedef struct OS_THREAD_WA_S {
     TX_SEMAPHORE                join_sem ;
     TX_EVENT_FLAGS_GROUP        suspend_evt ;
     int32_t                     suspend_msg ;
+    uint32_t                    notify_value ;
     int32_t                     errorno ;
     void *                      arg ;
     p_thread_function_t         pf ;
@@ -191,6 +204,7 @@ os_thread_create (uint16_t stack_size, uint32_t prio, p_thread_function_t pf,
     wa->pf  = pf ;
     wa->arg = arg ;
     wa->heap = 1 ;
+    wa->stack_size = size ;
     xSemaphoreCreateCountingStatic ((UBaseType_t)-1, 0, (StaticSemaphore_t *)(&wa->join_sem)) ;
     xSemaphoreCreateCountingStatic ((UBaseType_t)-1, 0, (StaticSemaphore_t *)(&wa->thread_sem)) ;
     wa->pthread_sem = &wa->thread_sem ;
@@ -302,6 +316,7 @@ os_thread_create_static (void *wsp, uint16_t size, uint32_t prio,
     wa->pf  = pf ;
     wa->arg = arg ;
     wa->heap = 0 ;
+    wa->stack_size = size - sizeof(OS_THREAD_WA_T) ;
     xSemaphoreCreateCountingStatic ((UBaseType_t)-1, 0, (StaticSemaphore_t *)(&wa->join_sem)) ;
     xSemaphoreCreateCountingStatic ((UBaseType_t)-1, 0, (StaticSemaphore_t *)(&wa->thread_sem)) ;
     wa->pthread_sem = &wa->thread_sem ;
@@ -381,6 +396,88 @@ os_thread_get_name (p_thread_t* thread)
 #endif
 }
 
+/**
+ * @brief   Stack and CPU usage of a thread created with os_thread_create.
+ * @note    ChibiOS measures the stack with CH_DBG_FILL_THREADS, ThreadX
+ *          unless TX_DISABLE_STACK_FILLING. CPU time needs
+ *          configGENERATE_RUN_TIME_STATS on FreeRTOS and
+ *          TX_EXECUTION_PROFILE_ENABLE on ThreadX, counting at
+ *          OS_RUNTIME_COUNTER_HZ.
+ *
+ * @param[in] thread        thread, 0 for the calling thread
+ * @param[out] stats
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_thread_get_stats (p_thread_t* thread, OS_THREAD_STATS_T * stats)
+{
+    p_thread_t t = 0 ;
+    if (thread == 0) {
+        thread = &t ;
+    }
+    if (*thread == 0) {
+        *thread = os_thread_current () ;
+    }
+    memset (stats, 0, sizeof(OS_THREAD_STATS_T)) ;
+
+#if defined CFG_OS_CHIBIOS && CFG_OS_CHIBIOS
+    thread_t * tp = (thread_t*) *thread ;
+    if (!tp->wa) {
+        return E_PARM ;
+    }
+    /* the thread structure sits at the top of its working area */
+    stats->stack_size = (uint8_t*)tp - (uint8_t*)tp->wa ;
+#if CH_DBG_FILL_THREADS == TRUE
+    {
+        const uint8_t * p = (const uint8_t*)tp->wa ;
+        while ((p < (const uint8_t*)tp) && (*p == CH_DBG_STACK_FILL_VALUE)) p++ ;
+        stats->stack_used = (const uint8_t*)tp - p ;
+    }
+#endif
+    return EOK ;
+#endif
+#if defined CFG_OS_FREERTOS && CFG_OS_FREERTOS
+    OS_THREAD_WA_T * wa = (OS_THREAD_WA_T*) *thread ;
+    stats->stack_size = wa->stack_size ;
+#if INCLUDE_uxTaskGetStackHighWaterMark
+    stats->stack_used = wa->stack_size -
+            uxTaskGetStackHighWaterMark ((TaskHandle_t)*thread) * sizeof(StackType_t) ;
+#endif
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configUSE_TRACE_FACILITY == 1 )
+    {
+        TaskStatus_t status ;
+        vTaskGetInfo ((TaskHandle_t)*thread, &status, pdFALSE, eInvalid) ;
+        stats->runtime_us = (uint64_t)status.ulRunTimeCounter * 1000000ULL /
+                OS_RUNTIME_COUNTER_HZ ;
+    }
+#endif
+    return EOK ;
+#endif
+#if defined CFG_OS_THREADX && CFG_OS_THREADX
+    TX_THREAD * tp = (TX_THREAD*) *thread ;
+    stats->stack_size = tp->tx_thread_stack_size ;
+#ifndef TX_DISABLE_STACK_FILLING
+    {
+        const ULONG * p = (const ULONG*)tp->tx_thread_stack_start ;
+        const ULONG * end = (const ULONG*)tp->tx_thread_stack_end ;
+        while ((p < end) && (*p == TX_STACK_FILL)) p++ ;
+        stats->stack_used = (uint8_t*)end - (uint8_t*)p ;
+    }
+#endif
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+    {
+        EXECUTION_TIME time = 0 ;
+        _tx_execution_thread_time_get (tp, &time) ;
+        stats->runtime_us = (uint64_t)time * 1000000ULL / OS_RUNTIME_COUNTER_HZ ;
+    }
+#endif
+    return EOK ;
+#endif
+}
+
 p_thread_t
 os_thread_current (void)
 {
@@ -817,6 +914,138 @@ os_thread_notify_isr (p_thread_t* thread, int32_t msg)
     return E_NOIMPL ;
 }
 
+/**
+ * @brief   Adds one to the notification value of the thread.
+ * @note    The notification is shared with os_thread_wait() and
+ *          os_thread_notify() on FreeRTOS, use one or the other.
+ * @note    Not implemented on ChibiOS, its event flags cannot count and
+ *          the thread has no field to keep the value in.
+ *
+ * @param[in] thread        thread to notify
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_thread_notify_give (p_thread_t* thread)
+{
+#if defined CFG_OS_FREERTOS && CFG_OS_FREERTOS
+    xTaskNotifyGiveIndexed ((TaskHandle_t)(*thread), 1) ;
+    return EOK ;
+#endif
+#if defined CFG_OS_THREADX && CFG_OS_THREADX
+    OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)*thread ;
+    os_sys_lock () ;
+    wa->notify_value++ ;
+    os_sys_unlock () ;
+    tx_event_flags_set(&wa->suspend_evt, 2, TX_OR ) ;
+    return EOK ;
+#endif
+    return E_NOIMPL ;
+}
+
+/**
+ * @brief   Sets bits in the notification value of the thread.
+ * @note    Not implemented on ChibiOS, see os_thread_notify_give().
+ *
+ * @param[in] thread        thread to notify
+ * @param[in] bits          bits to set
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_thread_notify_bits (p_thread_t* thread, uint32_t bits)
+{
+#if defined CFG_OS_FREERTOS && CFG_OS_FREERTOS
+    xTaskNotifyIndexed ((TaskHandle_t)(*thread), 1, bits, eSetBits) ;
+    return EOK ;
+#endif
+#if defined CFG_OS_THREADX && CFG_OS_THREADX
+    OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)*thread ;
+    os_sys_lock () ;
+    wa->notify_value |= bits ;
+    os_sys_unlock () ;
+    tx_event_flags_set(&wa->suspend_evt, 2, TX_OR ) ;
+    return EOK ;
+#endif
+    return E_NOIMPL ;
+}
+
+/**
+ * @brief   Waits for the notification value of the calling thread to be
+ *          non zero, then clears it or takes one from it.
+ * @note    Returns 0 right away on ChibiOS, see os_thread_notify_give().
+ *
+ * @param[in] clear         clear the value, else decrement it
+ * @param[in] ticks         timeout
+ *
+ * @return              The notification value before it was taken, 0 on
+ *                      timeout.
+ *
+ * @api
+ */
+uint32_t
+os_thread_notify_take (uint32_t clear, uint32_t ticks)
+{
+#if defined CFG_OS_FREERTOS && CFG_OS_FREERTOS
+    return ulTaskNotifyTakeIndexed (1, clear ? pdTRUE : pdFALSE, ticks) ;
+#endif
+#if defined CFG_OS_THREADX && CFG_OS_THREADX
+    OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)tx_thread_identify () ;
+    uint32_t value ;
+    ULONG flags ;
+
+    for (;;) {
+        os_sys_lock () ;
+        value = wa->notify_value ;
+        if (value) {
+            wa->notify_value = clear ? 0 : value - 1 ;
+        }
+        os_sys_unlock () ;
+        if (value) {
+            return value ;
+        }
+        if (tx_event_flags_get(&wa->suspend_evt, 2,
+                TX_OR_CLEAR, &flags, ticks) != TX_SUCCESS) {
+            return 0 ;
+        }
+    }
+#endif
+    return 0 ;
+}
+
+/**
+ * @brief   Discards any notification pending for the calling thread,
+ *          without waiting.
+ * @note    On ChibiOS this clears the event flags os_thread_wait() waits
+ *          for, the only notification that port has.
+ *
+ * @api
+ */
+void
+os_thread_notify_clear (void)
+{
+#if defined CFG_OS_CHIBIOS && CFG_OS_CHIBIOS
+    chEvtGetAndClearEvents (SVC_EVENTS_ALL) ;
+#endif
+#if defined CFG_OS_FREERTOS && CFG_OS_FREERTOS
+    xTaskNotifyStateClearIndexed (NULL, 1) ;
+    ulTaskNotifyValueClearIndexed (NULL, 1, 0xFFFFFFFF) ;
+#endif
+#if defined CFG_OS_THREADX && CFG_OS_THREADX
+    OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)tx_thread_identify () ;
+    ULONG flags ;
+
+    os_sys_lock () ;
+    wa->notify_value = 0 ;
+    os_sys_unlock () ;
+    tx_event_flags_get(&wa->suspend_evt, 3, TX_OR_CLEAR, &flags, TX_NO_WAIT) ;
+#endif
+}
+
 /**
  * @brief   System start.
  * @details Start the scheduler.
@@ -970,6 +1199,32 @@ os_sys_us_timestamp (void)
 #endif
 }
 
+/**
+ * @brief       Monotonic time since start in nanoseconds. The 32 bit tick
+ *              counter is extended to 64 bits, this must be called at least
+ *              once per tick counter wrap.
+ */
+uint64_t
+os_sys_ns_timestamp (void)
+{
+    static uint32_t _ns_last_ticks = 0 ;
+    static uint32_t _ns_wraps = 0 ;
+    uint64_t ticks ;
+
+    os_sys_lock () ;
+    ticks = os_sys_ticks () ;
+    if ((uint32_t)ticks < _ns_last_ticks) {
+        _ns_wraps++ ;
+    }
+    _ns_last_ticks = (uint32_t)ticks ;
+    ticks |= (uint64_t)_ns_wraps << 32 ;
+    os_sys_unlock () ;
+
+    /* Split to keep the multiply inside 64 bits for long uptimes. */
+    return (ticks / OS_ST_FREQUENCY) * 1000000000ULL +
+            (ticks % OS_ST_FREQUENCY) * 1000000000ULL / OS_ST_FREQUENCY ;
+}
+
 void
 os_sys_stop(void)
 {
@@ -1153,6 +1408,27 @@ os_mutex_trylock (p_mutex_t* mutex)
 }
 #endif
 
+int32_t
+os_mutex_get_stats (p_mutex_t* mutex, OS_MUTEX_STATS_T * stats)
+{
+    (void)mutex ;
+    (void)stats ;
+    return E_NOIMPL ;
+}
+
+int32_t
+os_mutex_stats (p_mutex_stats_function_t fp, void * arg)
+{
+    (void)fp ;
+    (void)arg ;
+    return E_NOIMPL ;
+}
+
+void
+os_mutex_reset_stats (void)
+{
+}
+
 int32_t
 os_sem_init (p_sem_t* sem, int32_t cnt)
 {
@@ -22,6 +22,9 @@
  */
 
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE         /* sem_clockwait() */
+#endif
 #include "qoraal/config.h"
 #if CFG_OS_POSIX
 #include <unistd.h>
@@ -47,8 +50,35 @@
    Otherwise define it away or set E_NOIMPL. */
 #ifdef __linux__
 #include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/futex.h>
 #define HAVE_PTHREAD_TIMEDJOIN 1
 #endif
+#include <sched.h>
+
+/**
+ * @brief   Spins on a held os_sys_lock() before sleeping on it. The
+ *          sections it protects are a few instructions long.
+ */
+#ifndef OS_SYS_LOCK_SPIN
+#define OS_SYS_LOCK_SPIN            100
+#endif
+
+/**
+ * @brief   Tries on a held os_mutex_lock() before sleeping on it, 0 to sleep
+ *          right away.
+ */
+#ifndef OS_MUTEX_SPIN
+#define OS_MUTEX_SPIN               50
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define POSIX_CPU_RELAX()           __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define POSIX_CPU_RELAX()           __asm__ __volatile__ ("yield")
+#else
+#define POSIX_CPU_RELAX()
+#endif
 
 
 
@@ -75,6 +105,48 @@ static void start_timer_manager(void) ;
 static void stop_timer_manager(void) ;
 #endif
 
+/*
+ * All time keeping and timed waits use CLOCK_MONOTONIC. It does not jump
+ * with changes to the wall clock and clock_gettime() reads it through the
+ * vDSO without a system call. Condition variables are created on it and
+ * deadlines are absolute CLOCK_MONOTONIC times.
+ */
+static inline uint64_t
+posix_monotonic_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void
+posix_timespec (struct timespec * t, uint64_t ns)
+{
+    t->tv_sec  = (time_t)(ns / 1000000000ULL);
+    t->tv_nsec = (long)(ns % 1000000000ULL);
+}
+
+static void
+posix_deadline (struct timespec * t, uint32_t ticks)
+{
+    posix_timespec (t, posix_monotonic_ns () +
+            (uint64_t)OS_TICKS2MS((uint64_t)ticks) * 1000000ULL) ;
+}
+
+static int
+posix_cond_init (pthread_cond_t * cond)
+{
+    pthread_condattr_t attr;
+    int rc ;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    rc = pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return rc ;
+}
+
 /*--------------------------------------------------*
  *  POSIX TLS: we track a pointer to OS_THREAD_WA_T *
  *--------------------------------------------------*/
@@ -92,12 +164,79 @@ typedef struct OS_THREAD_WA_S {
         pthread_mutex_t                 suspend_mutex ;
         pthread_cond_t                  suspend_cond ;
         int32_t                         suspend_msg ;
+        uint32_t                        notify_value ;
+        uint32_t                        notify_waiting ;
 
         p_thread_function_t             pf ;
         uint32_t                        tls[MAX_TLS_ID] ;
 
+        uint32_t                        stack_size ;
+        uintptr_t                       stack_lo ;
+        uintptr_t                       stack_entry ;
+
 } OS_THREAD_WA_T ;
 
+#ifdef __linux__
+/*
+ * Threads run on the default pthread stack, not on one of stack_size. Which
+ * of its pages were ever touched shows how deep the thread went, so the
+ * pages below the entry frame are dropped at start in case the stack was
+ * reused from a thread that exited. Use is measured from the stack pointer
+ * at entry, above it are the TLS and the pthread descriptor.
+ */
+static void
+posix_stack_init (OS_THREAD_WA_T * wa)
+{
+    uintptr_t page = (uintptr_t) sysconf (_SC_PAGESIZE) ;
+    pthread_attr_t attr ;
+    void * addr ;
+    size_t size ;
+    uintptr_t entry = (uintptr_t)&addr ;
+    uintptr_t sp = entry & ~(page - 1) ;
+
+    if (pthread_getattr_np (pthread_self (), &attr) != 0) {
+        return ;
+    }
+    if (pthread_attr_getstack (&attr, &addr, &size) == 0) {
+        wa->stack_lo = ((uintptr_t)addr + page - 1) & ~(page - 1) ;
+        wa->stack_entry = entry ;
+        if (sp - page > wa->stack_lo) {
+            madvise ((void *)wa->stack_lo, sp - page - wa->stack_lo, MADV_DONTNEED) ;
+        }
+    }
+    pthread_attr_destroy (&attr) ;
+}
+
+/*
+ * Bytes from the stack pointer at entry down to the lowest page ever touched.
+ */
+static uint32_t
+posix_stack_used (OS_THREAD_WA_T * wa)
+{
+    uintptr_t page = (uintptr_t) sysconf (_SC_PAGESIZE) ;
+    uintptr_t addr = wa->stack_lo ;
+    unsigned char vec[64] ;
+    size_t n ;
+    size_t i ;
+
+    while (addr < wa->stack_entry) {
+        n = (wa->stack_entry - addr + page - 1) / page ;
+        if (n > sizeof(vec)) n = sizeof(vec) ;
+        if (mincore ((void *)addr, n * page, vec) != 0) {
+            return 0 ;
+        }
+        for (i=0; i<n; i++) {
+            if (vec[i] & 1) {
+                return (uint32_t)(wa->stack_entry - (addr + i * page)) ;
+            }
+        }
+        addr += n * page ;
+    }
+
+    return 0 ;
+}
+#endif
+
 /* 
  * The actual function that runs in the new thread. 
  */
@@ -110,11 +249,9 @@ task_start (void * arg)
     if (g_posix_wa_key_init) {
         pthread_setspecific(g_posix_wa_key, wa);
     }
-
-    /* Initialize these in creation or here? Let's do them here. */
-    pthread_mutex_init(&wa->suspend_mutex, NULL);
-    pthread_cond_init(&wa->suspend_cond, NULL);
-        wa->suspend_msg = 0 ;
+#ifdef __linux__
+    posix_stack_init (wa) ;
+#endif
 
     /* Actually run user function. */
     wa->pf (wa->arg) ;
@@ -186,11 +323,15 @@ os_thread_create (uint16_t stack_size, uint32_t prio, p_thread_function_t pf,
         wa->pf  = pf ;
         wa->arg = arg ;
         wa->heap = 1 ;
+        wa->stack_size = stack_size ;
 
         if (sem_init(&wa->join_sem, 0, 0) != 0) {
             qoraal_free (QORAAL_HeapOperatingSystem, wa);
             return EFAIL;
         }
+        /* the thread may be notified before it starts running */
+        pthread_mutex_init(&wa->suspend_mutex, NULL);
+        posix_cond_init(&wa->suspend_cond);
 
     /* Initialize attributes if you want to set priority. 
        Realistically, setting sched_priority requires root privileges on many systems,
@@ -206,6 +347,8 @@ os_thread_create (uint16_t stack_size, uint32_t prio, p_thread_function_t pf,
     pthread_attr_destroy(&tattr);
 
     if (ret != 0) {
+        pthread_mutex_destroy(&wa->suspend_mutex);
+        pthread_cond_destroy(&wa->suspend_cond);
         sem_destroy(&wa->join_sem);
         qoraal_free(QORAAL_HeapOperatingSystem, wa);
         return EFAIL;
@@ -256,10 +399,14 @@ os_thread_create_static (void *wsp, uint16_t size, uint32_t prio,
     wa->pf  = pf ;
     wa->arg = arg ;
     wa->heap = 0 ;
+    wa->stack_size = size ;
 
     if (sem_init(&wa->join_sem, 0, 0) != 0) {
         return EFAIL;
     }
+    /* the thread may be notified before it starts running */
+    pthread_mutex_init(&wa->suspend_mutex, NULL);
+    posix_cond_init(&wa->suspend_cond);
 
     pthread_attr_init(&tattr);
 #if 1
@@ -272,6 +419,8 @@ os_thread_create_static (void *wsp, uint16_t size, uint32_t prio,
     pthread_attr_destroy(&tattr);
 
     if (ret != 0) {
+        pthread_mutex_destroy(&wa->suspend_mutex);
+        pthread_cond_destroy(&wa->suspend_cond);
         sem_destroy(&wa->join_sem);
         return EFAIL;
     }
@@ -298,6 +447,47 @@ os_thread_get_name (p_thread_t* thread)
     return "posix thread" ;
 }
 
+/**
+ * @brief   Stack and CPU usage of a thread created with os_thread_create.
+ * @note    The stack is measured in whole pages of the pthread stack, which
+ *          can be larger than stack_size. Only for threads still running.
+ *
+ * @param[in] thread        thread, 0 for the calling thread
+ * @param[out] stats
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_thread_get_stats (p_thread_t* thread, OS_THREAD_STATS_T * stats)
+{
+    OS_THREAD_WA_T * wa ;
+    clockid_t cid ;
+    struct timespec ts ;
+
+    memset (stats, 0, sizeof(OS_THREAD_STATS_T)) ;
+    if (thread && *thread) {
+        wa = (OS_THREAD_WA_T *) *thread ;
+    } else {
+        wa = g_posix_wa_key_init ? pthread_getspecific (g_posix_wa_key) : 0 ;
+    }
+    if (!wa) {
+        return E_PARM ;
+    }
+
+    stats->stack_size = wa->stack_size ;
+#ifdef __linux__
+    stats->stack_used = posix_stack_used (wa) ;
+#endif
+    if ((pthread_getcpuclockid (wa->tid, &cid) == 0) &&
+            (clock_gettime (cid, &ts) == 0)) {
+        stats->runtime_us = (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000 ;
+    }
+
+    return EOK ;
+}
+
 p_thread_t
 os_thread_current (void)
 {
@@ -417,7 +607,7 @@ os_thread_tls_alloc (int32_t * index)
 {
     int i ;
 
-    //os_sys_lock () ;
+    os_sys_lock () ;
     *index = -1 ;
     for (i=0; i<MAX_TLS_ID; i++) {
         if (_os_tls_values[i] == 0) break ;
@@ -427,7 +617,7 @@ os_thread_tls_alloc (int32_t * index)
         DBG_CHECK_T (0, EFAIL, "os_thread_tls_alloc out of tls!!") ;
     }
     _os_tls_values[i] = 1 ;
-    //os_sys_unlock () ;
+    os_sys_unlock () ;
     *index = i ;
     os_thread_tls_set (i, 0) ;
     return EOK;
@@ -437,9 +627,9 @@ void
 os_thread_tls_free (int32_t  index)
 {
     if ((index >= 0) && (index < MAX_TLS_ID)) {
-        //os_sys_lock () ;
+        os_sys_lock () ;
         _os_tls_values[index] = 0 ;
-        //os_sys_unlock () ;
+        os_sys_unlock () ;
     }
 }
 
@@ -449,7 +639,7 @@ os_thread_tls_set (int32_t idx, uint32_t value)
     if ((idx < 0 ) || (idx >= MAX_TLS_ID)) {
         return E_PARM ;
     }
-    OS_THREAD_WA_T  * wa = pthread_getspecific(g_posix_wa_key);
+    OS_THREAD_WA_T  * wa = g_posix_wa_key_init ? pthread_getspecific (g_posix_wa_key) : 0 ;
     if (wa) {
         wa->tls[idx] = value;
         return EOK;
@@ -463,7 +653,7 @@ os_thread_tls_get (int32_t idx)
     if ((idx < 0 ) || (idx >= MAX_TLS_ID)) {
         return 0 ;
     }
-    OS_THREAD_WA_T  * wa = pthread_getspecific(g_posix_wa_key);
+    OS_THREAD_WA_T  * wa = g_posix_wa_key_init ? pthread_getspecific (g_posix_wa_key) : 0 ;
     if (wa) {
         return wa->tls[idx];
     }
@@ -511,39 +701,186 @@ os_thread_sleep_ticks (uint32_t ticks)
     }
 }
 
+/*
+ * The thread notification is one 32-bit value, given to as a count or as
+ * bits and taken by the thread itself. On Linux the value is the futex:
+ * the signal side is one atomic operation and only makes a system call
+ * when the thread sleeps in os_thread_notify_take(). notify_waiting is
+ * set before the thread checks the value for the last time, so either the
+ * signal sees it or the thread sees the new value.
+ */
+#ifdef __linux__
+static int32_t
+posix_notify (OS_THREAD_WA_T * wa, uint32_t old)
+{
+    if (!old && __atomic_load_n(&wa->notify_waiting, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &wa->notify_value, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+    return EOK ;
+}
+#endif
+
+/**
+ * @brief   Adds one to the notification value of the thread.
+ *
+ * @param[in] thread        thread to notify
+ *
+ * @return              Error.
+ *
+ * @api
+ */
 int32_t
-os_thread_wait (uint32_t ticks)
+os_thread_notify_give (p_thread_t* thread)
 {
-    int32_t res;
-    OS_THREAD_WA_T  * wa = pthread_getspecific(g_posix_wa_key);
+    OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)*thread ;
+    if (!wa) return E_PARM;
+
+#ifdef __linux__
+    return posix_notify (wa, __atomic_fetch_add(&wa->notify_value, 1, __ATOMIC_SEQ_CST)) ;
+#else
+    pthread_mutex_lock (&wa->suspend_mutex);
+    wa->notify_value++ ;
+    pthread_cond_signal (&wa->suspend_cond);
+    pthread_mutex_unlock (&wa->suspend_mutex);
+    return EOK ;
+#endif
+}
+
+/**
+ * @brief   Sets bits in the notification value of the thread.
+ *
+ * @param[in] thread        thread to notify
+ * @param[in] bits          bits to set
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_thread_notify_bits (p_thread_t* thread, uint32_t bits)
+{
+    OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)*thread ;
+    if (!wa) return E_PARM;
+
+#ifdef __linux__
+    return posix_notify (wa, __atomic_fetch_or(&wa->notify_value, bits, __ATOMIC_SEQ_CST)) ;
+#else
+    pthread_mutex_lock (&wa->suspend_mutex);
+    wa->notify_value |= bits ;
+    pthread_cond_signal (&wa->suspend_cond);
+    pthread_mutex_unlock (&wa->suspend_mutex);
+    return EOK ;
+#endif
+}
+
+/**
+ * @brief   Waits for the notification value of the calling thread to be
+ *          non zero, then clears it or takes one from it.
+ *
+ * @param[in] clear         clear the value, else decrement it
+ * @param[in] ticks         timeout
+ *
+ * @return              The notification value before it was taken, 0 on
+ *                      timeout.
+ *
+ * @api
+ */
+uint32_t
+os_thread_notify_take (uint32_t clear, uint32_t ticks)
+{
+    OS_THREAD_WA_T  * wa = g_posix_wa_key_init ? pthread_getspecific (g_posix_wa_key) : 0 ;
+    struct timespec t;
+    uint32_t value ;
+
     if (!wa) {
-        return E_NOIMPL;
+        return 0;
+    }
+    if (ticks != OS_TIME_INFINITE) {
+        posix_deadline(&t, ticks);
     }
+
+#ifdef __linux__
+    value = __atomic_load_n(&wa->notify_value, __ATOMIC_ACQUIRE);
+    for (;;) {
+        if (value) {
+            if (__atomic_compare_exchange_n(&wa->notify_value, &value,
+                    clear ? 0 : value - 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                break ;
+            }
+            continue ;
+        }
+        if (!wa->notify_waiting) {
+            __atomic_store_n(&wa->notify_waiting, 1, __ATOMIC_SEQ_CST);
+            value = __atomic_load_n(&wa->notify_value, __ATOMIC_SEQ_CST);
+            continue ;
+        }
+        if ((syscall(SYS_futex, &wa->notify_value, FUTEX_WAIT_BITSET_PRIVATE, 0,
+                ticks != OS_TIME_INFINITE ? &t : NULL, NULL, FUTEX_BITSET_MATCH_ANY) != 0) &&
+                (errno == ETIMEDOUT)) {
+            value = __atomic_load_n(&wa->notify_value, __ATOMIC_ACQUIRE);
+            if (!value) {
+                break ;
+            }
+            continue ;
+        }
+        value = __atomic_load_n(&wa->notify_value, __ATOMIC_ACQUIRE);
+    }
+    __atomic_store_n(&wa->notify_waiting, 0, __ATOMIC_RELAXED);
+#else
     pthread_mutex_lock(&wa->suspend_mutex);
-    if (ticks == OS_TIME_INFINITE) {
-        /* indefinite wait */
-        pthread_cond_wait(&wa->suspend_cond, &wa->suspend_mutex);
-        res = wa->suspend_msg;
-    } else {
-        struct timespec t;
-        struct timeval  now;
-        gettimeofday(&now, NULL);
-        uint64_t ms     = (uint64_t) (ticks * 1000ULL / os_sys_tick_freq());
-        uint64_t nsec   = (now.tv_usec + (ms % 1000) * 1000ULL) * 1000ULL;
-        t.tv_sec        = now.tv_sec + (ms / 1000) + (nsec / 1000000000ULL);
-        t.tv_nsec       = (long)(nsec % 1000000000ULL);
-
-        int rc = pthread_cond_timedwait(&wa->suspend_cond, &wa->suspend_mutex, &t);
-        if (rc == 0) {
-            res = wa->suspend_msg;
-        } else if (rc == ETIMEDOUT) {
-            res = E_TIMEOUT;
-        } else {
-            res = EFAIL;
+    while (!wa->notify_value) {
+        if (ticks == OS_TIME_INFINITE) {
+            pthread_cond_wait(&wa->suspend_cond, &wa->suspend_mutex);
+        } else if (pthread_cond_timedwait(&wa->suspend_cond, &wa->suspend_mutex, &t) == ETIMEDOUT) {
+            break ;
         }
     }
+    value = wa->notify_value ;
+    if (value) {
+        wa->notify_value = clear ? 0 : value - 1 ;
+    }
     pthread_mutex_unlock(&wa->suspend_mutex);
-    return res;
+#endif
+
+    return value ;
+}
+
+/**
+ * @brief   Discards any notification pending for the calling thread,
+ *          without waiting.
+ *
+ * @api
+ */
+void
+os_thread_notify_clear (void)
+{
+    OS_THREAD_WA_T  * wa = g_posix_wa_key_init ? pthread_getspecific (g_posix_wa_key) : 0 ;
+
+    if (!wa) {
+        return;
+    }
+#ifdef __linux__
+    __atomic_store_n(&wa->notify_value, 0, __ATOMIC_RELEASE);
+#else
+    pthread_mutex_lock(&wa->suspend_mutex);
+    wa->notify_value = 0 ;
+    pthread_mutex_unlock(&wa->suspend_mutex);
+#endif
+}
+
+int32_t
+os_thread_wait (uint32_t ticks)
+{
+    OS_THREAD_WA_T  * wa = g_posix_wa_key_init ? pthread_getspecific (g_posix_wa_key) : 0 ;
+    if (!wa) {
+        return E_NOIMPL;
+    }
+
+    /* a notify before the wait is not lost, several collapse into one */
+    if (!os_thread_notify_take (1, ticks)) {
+        return E_TIMEOUT ;
+    }
+    return __atomic_load_n(&wa->suspend_msg, __ATOMIC_ACQUIRE) ;
 }
 
 int32_t
@@ -552,11 +889,8 @@ os_thread_notify (p_thread_t* thread, int32_t msg)
     OS_THREAD_WA_T  * wa = (OS_THREAD_WA_T*)*thread ;
     if (!wa) return E_NOIMPL;
 
-    pthread_mutex_lock (&wa->suspend_mutex);
-    wa->suspend_msg = msg ;
-    pthread_cond_signal (&wa->suspend_cond);
-    pthread_mutex_unlock (&wa->suspend_mutex);
-    return EOK ;
+    __atomic_store_n(&wa->suspend_msg, msg, __ATOMIC_RELEASE);
+    return os_thread_notify_bits (thread, 1) ;
 }
 
 int32_t
@@ -583,17 +917,75 @@ os_sys_started (void)
     return _os_started ;
 }
 
+/*
+ * os_sys_lock() is one process wide lock, recursive per thread. The lock
+ * word is 0 when free, 1 when held and 2 when held with sleeping waiters,
+ * so an uncontended lock and unlock is one atomic operation each and the
+ * kernel is only entered to sleep or to wake a waiter.
+ */
+static int                      _os_sys_lock_word = 0 ;
+static __thread uint32_t        _os_sys_lock_depth = 0 ;
+
+static void
+posix_sys_lock_wait (int * word)
+{
+#ifdef __linux__
+    syscall (SYS_futex, word, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0) ;
+#else
+    (void)word ;
+    sched_yield () ;
+#endif
+}
+
+static void
+posix_sys_lock_wake (int * word)
+{
+#ifdef __linux__
+    syscall (SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0) ;
+#else
+    (void)word ;
+#endif
+}
+
 void
 os_sys_lock (void)
 {
+    int c = 0 ;
+    int i ;
+
+    if (_os_sys_lock_depth++) {
+        return ;
+    }
 
+    for (i=0; i<OS_SYS_LOCK_SPIN; i++) {
+        c = 0 ;
+        if (__atomic_compare_exchange_n (&_os_sys_lock_word, &c, 1, 0,
+                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return ;
+        }
+        POSIX_CPU_RELAX () ;
+    }
+
+    if (c != 2) {
+        c = __atomic_exchange_n (&_os_sys_lock_word, 2, __ATOMIC_ACQUIRE) ;
+    }
+    while (c != 0) {
+        posix_sys_lock_wait (&_os_sys_lock_word) ;
+        c = __atomic_exchange_n (&_os_sys_lock_word, 2, __ATOMIC_ACQUIRE) ;
+    }
 }
 
 
 void
 os_sys_unlock (void)
 {
+    if (!_os_sys_lock_depth || --_os_sys_lock_depth) {
+        return ;
+    }
 
+    if (__atomic_exchange_n (&_os_sys_lock_word, 0, __ATOMIC_RELEASE) == 2) {
+        posix_sys_lock_wake (&_os_sys_lock_word) ;
+    }
 }
 
 uint32_t
@@ -607,27 +999,26 @@ os_sys_tick_freq (void)
 uint32_t
 os_sys_ticks (void)
 {
-    /* We'll fake it by returning ms from gettimeofday. */
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint32_t)((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+    /* 1 tick is 1 ms, see os_sys_tick_freq(). */
+    return (uint32_t)(posix_monotonic_ns () / 1000000ULL);
 }
 
 uint32_t
 os_sys_timestamp (void)
 {
-    /* Just do the same: get ms since start of epoch? */
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint32_t)((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+    return (uint32_t)(posix_monotonic_ns () / 1000000ULL);
 }
 
 uint32_t
 os_sys_us_timestamp (void)
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint32_t)(tv.tv_sec * 1000000 + tv.tv_usec);
+    return (uint32_t)(posix_monotonic_ns () / 1000ULL);
+}
+
+uint64_t
+os_sys_ns_timestamp (void)
+{
+    return posix_monotonic_ns () ;
 }
 
 void
@@ -657,14 +1048,39 @@ os_sys_is_irq (void)
 } 
 
 #if !defined CFG_OS_MUTEX_DISABLE
+/*
+ * Mutexes are recursive. os_mutex_lock() first tries to take the mutex,
+ * then spins for up to OS_MUTEX_SPIN tries, the sections they guard being
+ * short, and only then sleeps in pthread_mutex_lock(). The clock is only
+ * read on contention. Statistics are updated by the owner while it holds
+ * the mutex.
+ */
+static pthread_mutex_t          _os_mutex_list_lock = PTHREAD_MUTEX_INITIALIZER ;
+static os_mutex_t *             _os_mutex_list = 0 ;
+
+static void
+posix_mutex_unlink (os_mutex_t * m)
+{
+    os_mutex_t ** prev ;
+
+    pthread_mutex_lock (&_os_mutex_list_lock) ;
+    for (prev = &_os_mutex_list; *prev; prev = &(*prev)->next) {
+        if (*prev == m) {
+            *prev = m->next ;
+            break ;
+        }
+    }
+    pthread_mutex_unlock (&_os_mutex_list_lock) ;
+}
+
 int32_t 
 os_mutex_init (p_mutex_t* mutex)
 {
-    if (mutex == NULL) {
+    if (mutex == NULL || *mutex == NULL) {
         return EFAIL;
     }
 
-
+    os_mutex_t * m = (os_mutex_t*)*mutex ;
     pthread_mutexattr_t attr;
     if (pthread_mutexattr_init(&attr) != 0) {
         return EFAIL;
@@ -672,13 +1088,22 @@ os_mutex_init (p_mutex_t* mutex)
 
     pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
 
-    if (pthread_mutex_init((pthread_mutex_t*)*mutex, &attr) != 0) {
+    if (pthread_mutex_init(&m->mutex, &attr) != 0) {
         pthread_mutexattr_destroy(&attr);
         
         return EFAIL;
     }
 
     pthread_mutexattr_destroy(&attr);
+
+    /* init may be repeated on a declared mutex */
+    posix_mutex_unlink (m) ;
+    memset (&m->stats, 0, sizeof(m->stats)) ;
+    pthread_mutex_lock (&_os_mutex_list_lock) ;
+    m->next = _os_mutex_list ;
+    _os_mutex_list = m ;
+    pthread_mutex_unlock (&_os_mutex_list_lock) ;
+
     return EOK;
 }
 #endif
@@ -688,7 +1113,8 @@ void
 os_mutex_deinit (p_mutex_t* mutex)
 {
     if (mutex && *mutex) {
-        pthread_mutex_destroy((pthread_mutex_t*)*mutex);
+        posix_mutex_unlink ((os_mutex_t*)*mutex) ;
+        pthread_mutex_destroy(&((os_mutex_t*)*mutex)->mutex);
         *mutex = NULL;
     }
 }
@@ -698,10 +1124,11 @@ os_mutex_deinit (p_mutex_t* mutex)
 int32_t 
 os_mutex_create (p_mutex_t* mutex)
 {
-    *mutex = qoraal_malloc(QORAAL_HeapOperatingSystem, sizeof(pthread_mutex_t)); // Allocate space for the mutex
+    *mutex = qoraal_malloc(QORAAL_HeapOperatingSystem, sizeof(os_mutex_t)); // Allocate space for the mutex
     if (*mutex == NULL) {
         return EFAIL;
     }
+    memset (*mutex, 0, sizeof(os_mutex_t)) ;
 
     int res = os_mutex_init (mutex);
     if (res != EOK) {
@@ -716,7 +1143,8 @@ void
 os_mutex_delete (p_mutex_t* mutex)
 {
     if (mutex && *mutex) {
-        pthread_mutex_destroy((pthread_mutex_t*)*mutex);
+        posix_mutex_unlink ((os_mutex_t*)*mutex) ;
+        pthread_mutex_destroy(&((os_mutex_t*)*mutex)->mutex);
         qoraal_free(QORAAL_HeapOperatingSystem, *mutex);
         *mutex = NULL;
     }
@@ -730,7 +1158,40 @@ os_mutex_lock (p_mutex_t *mutex)
     if (mutex == NULL || *mutex == NULL) {
         return EFAIL;
     }
-    return pthread_mutex_lock((pthread_mutex_t *)*mutex) == 0 ? EOK : EFAIL;
+
+    os_mutex_t * m = (os_mutex_t*)*mutex ;
+    uint64_t start ;
+    uint64_t wait ;
+    int spun = 0 ;
+    int i ;
+
+    if (pthread_mutex_trylock(&m->mutex) == 0) {
+        m->stats.locks++ ;
+        return EOK ;
+    }
+
+    start = posix_monotonic_ns () ;
+    for (i=0; i<OS_MUTEX_SPIN; i++) {
+        POSIX_CPU_RELAX () ;
+        if (pthread_mutex_trylock(&m->mutex) == 0) {
+            spun = 1 ;
+            break ;
+        }
+    }
+    if (!spun && (pthread_mutex_lock(&m->mutex) != 0)) {
+        return EFAIL ;
+    }
+
+    wait = posix_monotonic_ns () - start ;
+    m->stats.locks++ ;
+    m->stats.contended++ ;
+    m->stats.spun += spun ;
+    m->stats.wait_ns += wait ;
+    if (wait / 1000 > m->stats.max_wait_us) {
+        m->stats.max_wait_us = (uint32_t)(wait / 1000) ;
+    }
+
+    return EOK ;
 }
 #endif
 
@@ -739,7 +1200,7 @@ void
 os_mutex_unlock (p_mutex_t *mutex) 
 {
     if (mutex && *mutex) {
-        pthread_mutex_unlock((pthread_mutex_t *)*mutex);
+        pthread_mutex_unlock(&((os_mutex_t*)*mutex)->mutex);
     }
 }
 #endif
@@ -751,7 +1212,78 @@ os_mutex_trylock (p_mutex_t *mutex)
     if (mutex == NULL || *mutex == NULL) {
         return EFAIL;
     }
-    return pthread_mutex_trylock((pthread_mutex_t *)*mutex) == 0 ? EOK : EFAIL;
+    if (pthread_mutex_trylock(&((os_mutex_t*)*mutex)->mutex) != 0) {
+        return EFAIL ;
+    }
+    ((os_mutex_t*)*mutex)->stats.locks++ ;
+    return EOK ;
+}
+#endif
+
+#if !defined CFG_OS_MUTEX_DISABLE
+/**
+ * @brief   Returns the contention statistics of a mutex.
+ * @note    Read without taking the mutex.
+ *
+ * @param[in] mutex
+ * @param[out] stats
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_mutex_get_stats (p_mutex_t* mutex, OS_MUTEX_STATS_T * stats)
+{
+    if (mutex == NULL || *mutex == NULL) {
+        return E_PARM;
+    }
+    *stats = ((os_mutex_t*)*mutex)->stats ;
+    return EOK ;
+}
+
+/**
+ * @brief   Calls fp with the statistics of every initialised mutex.
+ * @note    Mutexes must not be created or deleted from fp.
+ *
+ * @param[in] fp
+ * @param[in] arg
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_mutex_stats (p_mutex_stats_function_t fp, void * arg)
+{
+    os_mutex_t * m ;
+    OS_MUTEX_STATS_T stats ;
+
+    pthread_mutex_lock (&_os_mutex_list_lock) ;
+    for (m = _os_mutex_list; m; m = m->next) {
+        stats = m->stats ;
+        fp (arg, m->name, (p_mutex_t)m, &stats) ;
+    }
+    pthread_mutex_unlock (&_os_mutex_list_lock) ;
+
+    return EOK ;
+}
+
+/**
+ * @brief   Clears the statistics of all mutexes.
+ *
+ * @api
+ */
+void
+os_mutex_reset_stats (void)
+{
+    os_mutex_t * m ;
+
+    pthread_mutex_lock (&_os_mutex_list_lock) ;
+    for (m = _os_mutex_list; m; m = m->next) {
+        memset (&m->stats, 0, sizeof(m->stats)) ;
+    }
+    pthread_mutex_unlock (&_os_mutex_list_lock) ;
 }
 #endif
 
@@ -821,12 +1353,27 @@ os_sem_wait_timeout (p_sem_t* sem, uint32_t ticks)
         return EFAIL;
     }
 
+    if (ticks == OS_TIME_INFINITE) {
+        return os_sem_wait (sem) ;
+    }
+
     struct timespec t;
+    int rc;
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 30)))
+    posix_deadline(&t, ticks);
+    while ((rc = sem_clockwait((sem_t*)(*sem), CLOCK_MONOTONIC, &t)) != 0 && errno == EINTR) { }
+#else
+    /* sem_timedwait() only takes CLOCK_REALTIME deadlines. */
     clock_gettime(CLOCK_REALTIME, &t);
-    t.tv_sec += OS_TICKS2MS(ticks) / 1000;
-    t.tv_nsec += (OS_TICKS2MS(ticks) % 1000) * 1000000;
+    posix_timespec(&t, (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec +
+            (uint64_t)OS_TICKS2MS((uint64_t)ticks) * 1000000ULL);
+    while ((rc = sem_timedwait((sem_t*)(*sem), &t)) != 0 && errno == EINTR) { }
+#endif
+    if (rc == 0) {
+        return EOK;
+    }
 
-    return sem_timedwait((sem_t*)(*sem), &t) == 0 ? EOK : EFAIL;
+    return errno == ETIMEDOUT ? E_TIMEOUT : EFAIL;
 }
 
 void 
@@ -893,7 +1440,143 @@ os_bsem_signal (p_sem_t* sem)
     os_sem_signal(sem);
 }
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && OS_POSIX_EVENT_FUTEX
+static inline int
+posix_event_ready (uint32_t flags, uint32_t mask, uint32_t all)
+{
+    return all ? ((flags & mask) == mask) : ((flags & mask) != 0) ;
+}
+
+int32_t
+os_event_init (p_event_t* event)
+{
+    if (event == NULL || *event == NULL) {
+        return EFAIL;
+    }
+
+    os_event_t* pevent = (os_event_t*)(*event);
+    pevent->flags = 0;
+    pevent->waiters = 0;
+    return EOK;
+}
+
+void
+os_event_deinit (p_event_t* event)
+{
+    (void)event ;
+}
+
+int32_t
+os_event_create (p_event_t* event)
+{
+    *event = qoraal_malloc(QORAAL_HeapOperatingSystem, sizeof(os_event_t));
+    if (*event == NULL) {
+        return EFAIL;
+    }
+
+    return os_event_init(event);
+}
+
+void
+os_event_delete (p_event_t* event)
+{
+    if (event && *event) {
+        qoraal_free(QORAAL_HeapOperatingSystem, *event);
+        *event = NULL;
+    }
+}
+
+void
+os_event_signal (p_event_t* event, uint32_t mask)
+{
+    if (event && *event) {
+        os_event_t* pevent = (os_event_t*)(*event);
+        uint32_t old = __atomic_fetch_or(&pevent->flags, mask, __ATOMIC_SEQ_CST);
+
+        /* only bits that were not set yet can satisfy a waiter */
+        if ((~old & mask) && __atomic_load_n(&pevent->waiters, __ATOMIC_SEQ_CST)) {
+            syscall(SYS_futex, &pevent->flags, FUTEX_WAKE_BITSET_PRIVATE,
+                    INT32_MAX, NULL, NULL, ~old & mask);
+        }
+    }
+}
+
+void
+os_event_signal_isr (p_event_t* event, uint32_t mask)
+{
+    os_event_signal(event, mask) ;
+}
+
+void
+os_event_clear (p_event_t* event, uint32_t mask)
+{
+    if (event && *event) {
+        os_event_t* pevent = (os_event_t*)(*event);
+        __atomic_fetch_and(&pevent->flags, ~mask, __ATOMIC_SEQ_CST);
+    }
+}
+
+uint32_t
+os_event_wait_timeout (p_event_t* event, uint32_t clear_on_exit, uint32_t mask, uint32_t all, uint32_t ticks)
+{
+    if (event == NULL || *event == NULL || !mask) {
+        return 0;
+    }
+
+    os_event_t* pevent = (os_event_t*)(*event);
+    struct timespec t;
+    uint32_t flags = __atomic_load_n(&pevent->flags, __ATOMIC_ACQUIRE);
+    uint32_t events;
+    int waiting = 0;
+
+    if (ticks != OS_TIME_INFINITE) {
+        posix_deadline(&t, ticks);
+    }
+
+    for (;;) {
+        while (posix_event_ready (flags, mask, all)) {
+            events = flags & mask;
+            if (!clear_on_exit ||
+                    __atomic_compare_exchange_n(&pevent->flags, &flags, flags & ~events,
+                            0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                if (waiting) {
+                    __atomic_sub_fetch(&pevent->waiters, 1, __ATOMIC_SEQ_CST);
+                }
+                return events;
+            }
+        }
+
+        if (!waiting) {
+            /* register first, then check again before sleeping */
+            __atomic_add_fetch(&pevent->waiters, 1, __ATOMIC_SEQ_CST);
+            waiting = 1;
+            flags = __atomic_load_n(&pevent->flags, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        /* returns at once if flags changed since it was read */
+        if ((syscall(SYS_futex, &pevent->flags, FUTEX_WAIT_BITSET_PRIVATE, flags,
+                ticks != OS_TIME_INFINITE ? &t : NULL, NULL, mask) != 0) &&
+                (errno == ETIMEDOUT)) {
+            flags = __atomic_load_n(&pevent->flags, __ATOMIC_ACQUIRE);
+            if (!posix_event_ready (flags, mask, all)) {
+                __atomic_sub_fetch(&pevent->waiters, 1, __ATOMIC_SEQ_CST);
+                return 0;
+            }
+            continue;
+        }
+        flags = __atomic_load_n(&pevent->flags, __ATOMIC_ACQUIRE);
+    }
+}
+
+uint32_t
+os_event_wait (p_event_t* event, uint32_t clear_on_exit, uint32_t mask, uint32_t all)
+{
+    return os_event_wait_timeout (event, clear_on_exit, mask, all, OS_TIME_INFINITE) ;
+}
+#endif
+
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 int32_t 
 os_event_init (p_event_t* event)
 {
@@ -902,7 +1585,7 @@ os_event_init (p_event_t* event)
     }
 
     os_event_t* pevent = (os_event_t*)(*event);
-    if (pthread_cond_init(&pevent->cond, NULL) != 0 ||
+    if (posix_cond_init(&pevent->cond) != 0 ||
         pthread_mutex_init(&pevent->mutex, NULL) != 0) {
         qoraal_free(QORAAL_HeapOperatingSystem, *event);
         *event = NULL;
@@ -914,7 +1597,7 @@ os_event_init (p_event_t* event)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 void 
 os_event_deinit (p_event_t* event)
 {
@@ -926,7 +1609,7 @@ os_event_deinit (p_event_t* event)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 int32_t 
 os_event_create (p_event_t* event)
 {
@@ -939,7 +1622,7 @@ os_event_create (p_event_t* event)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 void 
 os_event_delete (p_event_t* event)
 {
@@ -951,7 +1634,7 @@ os_event_delete (p_event_t* event)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 void 
 os_event_signal (p_event_t* event, uint32_t mask)
 {
@@ -965,7 +1648,7 @@ os_event_signal (p_event_t* event, uint32_t mask)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 void 
 os_event_signal_isr (p_event_t* event, uint32_t mask)
 {
@@ -973,7 +1656,7 @@ os_event_signal_isr (p_event_t* event, uint32_t mask)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 void 
 os_event_clear (p_event_t* event, uint32_t mask)
 {
@@ -986,7 +1669,7 @@ os_event_clear (p_event_t* event, uint32_t mask)
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 uint32_t 
 os_event_wait (p_event_t* event, uint32_t clear_on_exit, uint32_t mask, uint32_t all)
 {
@@ -1011,7 +1694,7 @@ os_event_wait (p_event_t* event, uint32_t clear_on_exit, uint32_t mask, uint32_t
 }
 #endif
 
-#if !defined CFG_OS_EVENT_DISABLE
+#if !defined CFG_OS_EVENT_DISABLE && !OS_POSIX_EVENT_FUTEX
 uint32_t 
 os_event_wait_timeout (p_event_t* event, uint32_t clear_on_exit, uint32_t mask, uint32_t all, uint32_t ticks)
 {
@@ -1023,13 +1706,7 @@ os_event_wait_timeout (p_event_t* event, uint32_t clear_on_exit, uint32_t mask,
     uint32_t events = 0;
 
     struct timespec t;
-    clock_gettime(CLOCK_REALTIME, &t);
-    t.tv_sec += OS_TICKS2MS(ticks) / 1000;
-    t.tv_nsec += (OS_TICKS2MS(ticks) % 1000) * 1000000;
-
-    // Normalize timespec
-    t.tv_sec += t.tv_nsec / 1000000000;
-    t.tv_nsec %= 1000000000;
+    posix_deadline(&t, ticks);
 
     pthread_mutex_lock(&pevent->mutex);
     while (all ? ((pevent->flags & mask) != mask) : !(pevent->flags & mask)) {
@@ -1065,9 +1742,7 @@ pthread_t       os_timer_thread;
 uint64_t 
 get_current_time_ms (void) 
 {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1e6;
+    return posix_monotonic_ns () / 1000000ULL;
 }
 
 void *
@@ -1091,9 +1766,9 @@ timer_thread (void *arg)
         uint64_t wait_time = manager->head->expire > now ? manager->head->expire - now : 0;
 
         if (wait_time > 0) {
+            /* the deadline is absolute, on the clock of the condition */
             struct timespec ts;
-            ts.tv_sec = wait_time / 1000;
-            ts.tv_nsec = (wait_time % 1000) * 1e6;
+            posix_timespec(&ts, manager->head->expire * 1000000ULL);
             pthread_cond_timedwait(&manager->cond, &manager->mutex, &ts);
         }
 
@@ -1105,6 +1780,7 @@ timer_thread (void *arg)
             manager->head = manager->head->next;
 
             expired_timer->in_processing = true; // Mark as being processed
+            expired_timer->is_set = false;       // The callback may set it again
             pthread_mutex_unlock(&manager->mutex);
 
             // Execute the callback
@@ -1113,7 +1789,6 @@ timer_thread (void *arg)
             }
 
             pthread_mutex_lock(&manager->mutex);
-            expired_timer->is_set = false;       // Mark the timer as expired
             expired_timer->in_processing = false; // No longer being processed
         }
         pthread_mutex_unlock(&manager->mutex);
@@ -1140,7 +1815,7 @@ start_timer_manager (void)
     pthread_mutexattr_destroy(&attr);
 
 
-    pthread_cond_init(&os_timer_manager.cond, NULL);
+    posix_cond_init(&os_timer_manager.cond);
     os_timer_manager.quit = false;
 
     pthread_create(&os_timer_thread, NULL, timer_thread, 0);
@@ -1204,14 +1879,9 @@ void os_timer_reset (p_timer_t *timer)
 
     pthread_mutex_lock(&os_timer_manager.mutex);
 
-    // If we're resetting a timer that's currently being processed in the callback,
-    // skip the wait or you'll deadlock yourself.
-    if (reset_timer->in_processing) {
-        pthread_mutex_unlock(&os_timer_manager.mutex);
-        return; 
-    }
-
-    // Remove the timer from the list if it's active
+    // Remove the timer from the list if it's active. A timer whose callback
+    // is running was taken off the list before, but the callback or another
+    // thread may have set it again since.
     os_timer_t **current = &os_timer_manager.head;
     while (*current && *current != reset_timer) {
         current = &(*current)->next;
@@ -1231,6 +1901,9 @@ os_timer_set (p_timer_t *timer, uint32_t ticks)
     os_timer_t *new_timer = (os_timer_t *)(*timer);
     if (!new_timer) return;
 
+    // The mutex is recursive, unlink and insert in one go so two threads
+    // setting the same timer cannot both insert it.
+    pthread_mutex_lock(&os_timer_manager.mutex);
     os_timer_reset(timer); // Ensure the timer is not already in the list
 
     new_timer->expire = get_current_time_ms() + ticks;
@@ -1238,8 +1911,6 @@ os_timer_set (p_timer_t *timer, uint32_t ticks)
     //new_timer->callback_param = parm;
     new_timer->is_set = true;
 
-    pthread_mutex_lock(&os_timer_manager.mutex);
-
     // Insert the timer into the sorted linked list
     os_timer_t **current = &os_timer_manager.head;
     while (*current && (*current)->expire <= new_timer->expire) {
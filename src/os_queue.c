@@ -0,0 +1,439 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+/*===========================================================================
+ * Queue
+ * @brief   Bounded multi-producer multi-consumer queue of pointers.
+ *          Every cell has a sequence number telling producers and
+ *          consumers whose turn it is, so a put or get is one compare and
+ *          swap on the tail or head plus a store to the cell, without a
+ *          lock. Batches reserve all their cells with one compare and swap.
+ *          Head and tail sit on their own cache lines.
+ *          The semaphores are only signalled when a thread waits on them.
+ *
+ * @{
+ *===========================================================================*/
+
+#include "qoraal/config.h"
+#if !defined CFG_OS_QUEUE_DISABLE
+#include <string.h>
+#include "qoraal/qoraal.h"
+
+#ifndef OS_QUEUE_CACHE_LINE
+#define OS_QUEUE_CACHE_LINE         64
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define QUEUE_LOAD(ptr)             __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define QUEUE_LOAD_ACQ(ptr)         __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define QUEUE_STORE_REL(ptr, val)   __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define QUEUE_CAS(ptr, exp, val)    __atomic_compare_exchange_n((ptr), (exp), (val), 1, \
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define QUEUE_FENCE()               __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+static inline int
+queue_cas (volatile uint32_t * ptr, uint32_t * exp, uint32_t val)
+{
+    int res ;
+    os_sys_lock () ;
+    res = (*ptr == *exp) ;
+    if (res) *ptr = val ;
+    else *exp = *ptr ;
+    os_sys_unlock () ;
+    return res ;
+}
+#define QUEUE_LOAD(ptr)             (*(volatile uint32_t *)(ptr))
+#define QUEUE_LOAD_ACQ(ptr)         (*(volatile uint32_t *)(ptr))
+#define QUEUE_STORE_REL(ptr, val)   do { os_sys_lock () ; *(ptr) = (val) ; os_sys_unlock () ; } while (0)
+#define QUEUE_CAS(ptr, exp, val)    queue_cas ((ptr), (exp), (val))
+#define QUEUE_FENCE()               do { os_sys_lock () ; os_sys_unlock () ; } while (0)
+#endif
+
+typedef struct OS_QUEUE_CELL_S {
+    uint32_t                    seq ;
+    void *                      item ;
+} OS_QUEUE_CELL_T ;
+
+typedef struct OS_QUEUE_S {
+    OS_QUEUE_CELL_T *           cells ;
+    uint32_t                    mask ;
+    p_sem_t                     items ;         /**< signalled for waiting consumers */
+    p_sem_t                     spaces ;        /**< signalled for waiting producers */
+    uint32_t                    get_waiters ;
+    uint32_t                    put_waiters ;
+    char                        pad0[OS_QUEUE_CACHE_LINE] ;
+    uint32_t                    tail ;          /**< next cell to put */
+    char                        pad1[OS_QUEUE_CACHE_LINE] ;
+    uint32_t                    head ;          /**< next cell to get */
+    char                        pad2[OS_QUEUE_CACHE_LINE] ;
+} OS_QUEUE_T ;
+
+/*===========================================================================*/
+/* Queue local functions.                                                    */
+/*===========================================================================*/
+
+/**
+ * @brief   Puts up to count items without waiting.
+ *
+ * @return              items put.
+ *
+ * @notapi
+ */
+static uint32_t
+queue_try_put (OS_QUEUE_T * q, void * const * items, uint32_t count)
+{
+    uint32_t pos = QUEUE_LOAD (&q->tail) ;
+    uint32_t n ;
+    uint32_t i ;
+
+    for (;;) {
+        /* free cells carry the position they are free for */
+        for (n=0; n<count; n++) {
+            if (QUEUE_LOAD_ACQ (&q->cells[(pos + n) & q->mask].seq) != pos + n) {
+                break ;
+            }
+        }
+        if (!n) {
+            if ((int32_t)(QUEUE_LOAD_ACQ (&q->cells[pos & q->mask].seq) - pos) < 0) {
+                return 0 ;      /* full */
+            }
+            pos = QUEUE_LOAD (&q->tail) ;
+            continue ;
+        }
+        if (QUEUE_CAS (&q->tail, &pos, pos + n)) {
+            break ;
+        }
+    }
+
+    for (i=0; i<n; i++) {
+        OS_QUEUE_CELL_T * cell = &q->cells[(pos + i) & q->mask] ;
+        cell->item = items[i] ;
+        QUEUE_STORE_REL (&cell->seq, pos + i + 1) ;
+    }
+
+    return n ;
+}
+
+/**
+ * @brief   Gets up to count items without waiting.
+ *
+ * @return              items taken.
+ *
+ * @notapi
+ */
+static uint32_t
+queue_try_get (OS_QUEUE_T * q, void ** items, uint32_t count)
+{
+    uint32_t pos = QUEUE_LOAD (&q->head) ;
+    uint32_t n ;
+    uint32_t i ;
+
+    for (;;) {
+        /* full cells carry their position plus one */
+        for (n=0; n<count; n++) {
+            if (QUEUE_LOAD_ACQ (&q->cells[(pos + n) & q->mask].seq) != pos + n + 1) {
+                break ;
+            }
+        }
+        if (!n) {
+            if ((int32_t)(QUEUE_LOAD_ACQ (&q->cells[pos & q->mask].seq) - (pos + 1)) < 0) {
+                return 0 ;      /* empty */
+            }
+            pos = QUEUE_LOAD (&q->head) ;
+            continue ;
+        }
+        if (QUEUE_CAS (&q->head, &pos, pos + n)) {
+            break ;
+        }
+    }
+
+    for (i=0; i<n; i++) {
+        OS_QUEUE_CELL_T * cell = &q->cells[(pos + i) & q->mask] ;
+        items[i] = cell->item ;
+        QUEUE_STORE_REL (&cell->seq, pos + i + q->mask + 1) ;
+    }
+
+    return n ;
+}
+
+/**
+ * @brief   Wakes up to n threads waiting on sem.
+ *
+ * @notapi
+ */
+static void
+queue_wake (p_sem_t * sem, uint32_t * waiters, uint32_t n)
+{
+    uint32_t w ;
+
+    /* pairs with the fence after a waiter registers */
+    QUEUE_FENCE () ;
+    w = QUEUE_LOAD (waiters) ;
+    if (n > w) n = w ;
+    while (n--) {
+        os_sem_signal (sem) ;
+    }
+}
+
+/**
+ * @brief   Waits on sem after registering in waiters, unless try succeeds
+ *          once registered.
+ *
+ * @return              items moved, 0 on timeout.
+ *
+ * @notapi
+ */
+static uint32_t
+queue_wait (OS_QUEUE_T * q, void ** items, uint32_t count, uint32_t ticks, int put)
+{
+    uint32_t * waiters = put ? &q->put_waiters : &q->get_waiters ;
+    p_sem_t * sem = put ? &q->spaces : &q->items ;
+    uint32_t start = os_sys_ticks () ;
+    uint32_t elapsed ;
+    uint32_t n ;
+
+    for (;;) {
+        OS_ATOMIC_INC (waiters) ;
+        QUEUE_FENCE () ;
+        n = put ? queue_try_put (q, items, count) : queue_try_get (q, items, count) ;
+        if (n) {
+            OS_ATOMIC_DEC (waiters) ;
+            return n ;
+        }
+
+        elapsed = os_sys_ticks () - start ;
+        if ((ticks != OS_TIME_INFINITE) && (elapsed >= ticks)) {
+            OS_ATOMIC_DEC (waiters) ;
+            return 0 ;
+        }
+        if (ticks == OS_TIME_INFINITE) {
+            os_sem_wait (sem) ;
+        } else {
+            os_sem_wait_timeout (sem, ticks - elapsed) ;
+        }
+        OS_ATOMIC_DEC (waiters) ;
+
+        /* a wake up may have been meant for a thread that got there first */
+        n = put ? queue_try_put (q, items, count) : queue_try_get (q, items, count) ;
+        if (n) {
+            return n ;
+        }
+    }
+}
+
+/*===========================================================================*/
+/* Queue external declarations.                                              */
+/*===========================================================================*/
+
+/**
+ * @brief   Creates a queue.
+ *
+ * @param[out] queue        queue
+ * @param[in] size          capacity, rounded up to a power of 2
+ *
+ * @return              Error.
+ *
+ * @api
+ */
+int32_t
+os_queue_create (p_queue_t* queue, uint32_t size)
+{
+    OS_QUEUE_T * q ;
+    uint32_t cap = 2 ;
+    uint32_t i ;
+
+    *queue = 0 ;
+    if (!size || (size > 0x40000000)) {
+        return E_PARM ;
+    }
+    while (cap < size) cap <<= 1 ;
+
+    q = qoraal_malloc (QORAAL_HeapOperatingSystem,
+                sizeof(OS_QUEUE_T) + cap * sizeof(OS_QUEUE_CELL_T)) ;
+    if (!q) {
+        return E_NOMEM ;
+    }
+    memset (q, 0, sizeof(OS_QUEUE_T)) ;
+    q->cells = (OS_QUEUE_CELL_T *)(q + 1) ;
+    q->mask = cap - 1 ;
+    for (i=0; i<cap; i++) {
+        q->cells[i].seq = i ;
+        q->cells[i].item = 0 ;
+    }
+
+    if (os_sem_create (&q->items, 0) != EOK) {
+        qoraal_free (QORAAL_HeapOperatingSystem, q) ;
+        return E_NOMEM ;
+    }
+    if (os_sem_create (&q->spaces, 0) != EOK) {
+        os_sem_delete (&q->items) ;
+        qoraal_free (QORAAL_HeapOperatingSystem, q) ;
+        return E_NOMEM ;
+    }
+
+    *queue = (p_queue_t) q ;
+    return EOK ;
+}
+
+/**
+ * @brief   Deletes a queue. Nobody may be using it.
+ *
+ * @param[in] queue         queue
+ *
+ * @api
+ */
+void
+os_queue_delete (p_queue_t* queue)
+{
+    OS_QUEUE_T * q = (OS_QUEUE_T *) *queue ;
+
+    if (q) {
+        os_sem_delete (&q->items) ;
+        os_sem_delete (&q->spaces) ;
+        qoraal_free (QORAAL_HeapOperatingSystem, q) ;
+        *queue = 0 ;
+    }
+}
+
+/**
+ * @brief   Puts items in the queue.
+ * @note    Waits for space until at least one item is put. Returns as soon
+ *          as any were put, the rest is left to the caller.
+ *
+ * @param[in] queue         queue
+ * @param[in] items         items
+ * @param[in] count         number of items
+ * @param[in] ticks         timeout, OS_TIME_IMMEDIATE to not wait
+ *
+ * @return              items put, 0 if the queue stayed full.
+ *
+ * @api
+ */
+uint32_t
+os_queue_put_batch (p_queue_t* queue, void * const * items, uint32_t count, uint32_t ticks)
+{
+    OS_QUEUE_T * q = (OS_QUEUE_T *) *queue ;
+    uint32_t n ;
+
+    if (!count) {
+        return 0 ;
+    }
+    n = queue_try_put (q, items, count) ;
+    if (!n && (ticks != OS_TIME_IMMEDIATE)) {
+        n = queue_wait (q, (void **)items, count, ticks, 1) ;
+    }
+    if (n) {
+        queue_wake (&q->items, &q->get_waiters, n) ;
+    }
+
+    return n ;
+}
+
+/**
+ * @brief   Gets items from the queue.
+ * @note    Waits until at least one item is available.
+ *
+ * @param[in] queue         queue
+ * @param[out] items        items
+ * @param[in] count         most items to get
+ * @param[in] ticks         timeout, OS_TIME_IMMEDIATE to not wait
+ *
+ * @return              items taken, 0 if the queue stayed empty.
+ *
+ * @api
+ */
+uint32_t
+os_queue_get_batch (p_queue_t* queue, void ** items, uint32_t count, uint32_t ticks)
+{
+    OS_QUEUE_T * q = (OS_QUEUE_T *) *queue ;
+    uint32_t n ;
+
+    if (!count) {
+        return 0 ;
+    }
+    n = queue_try_get (q, items, count) ;
+    if (!n && (ticks != OS_TIME_IMMEDIATE)) {
+        n = queue_wait (q, items, count, ticks, 0) ;
+    }
+    if (n) {
+        queue_wake (&q->spaces, &q->put_waiters, n) ;
+    }
+
+    return n ;
+}
+
+/**
+ * @brief   Puts an item in the queue.
+ *
+ * @param[in] queue         queue
+ * @param[in] item          item
+ * @param[in] ticks         timeout, OS_TIME_IMMEDIATE to not wait
+ *
+ * @return              EOK, or E_TIMEOUT if the queue stayed full.
+ *
+ * @api
+ */
+int32_t
+os_queue_put (p_queue_t* queue, void * item, uint32_t ticks)
+{
+    return os_queue_put_batch (queue, &item, 1, ticks) ? EOK : E_TIMEOUT ;
+}
+
+/**
+ * @brief   Gets an item from the queue.
+ *
+ * @param[in] queue         queue
+ * @param[out] item         item
+ * @param[in] ticks         timeout, OS_TIME_IMMEDIATE to not wait
+ *
+ * @return              EOK, or E_TIMEOUT if the queue stayed empty.
+ *
+ * @api
+ */
+int32_t
+os_queue_get (p_queue_t* queue, void ** item, uint32_t ticks)
+{
+    return os_queue_get_batch (queue, item, 1, ticks) ? EOK : E_TIMEOUT ;
+}
+
+/**
+ * @brief   Number of items in the queue, a snapshot while it is in use.
+ *
+ * @param[in] queue         queue
+ *
+ * @return              items queued.
+ *
+ * @api
+ */
+uint32_t
+os_queue_count (p_queue_t* queue)
+{
+    OS_QUEUE_T * q = (OS_QUEUE_T *) *queue ;
+    uint32_t head = QUEUE_LOAD_ACQ (&q->head) ;
+    uint32_t tail = QUEUE_LOAD_ACQ (&q->tail) ;
+    uint32_t count = tail - head ;
+
+    return (int32_t)count < 0 ? 0 : count > q->mask + 1 ? q->mask + 1 : count ;
+}
+
+#endif /* CFG_OS_QUEUE_DISABLE */
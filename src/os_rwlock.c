@@ -0,0 +1,269 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+/*===========================================================================
+ * RWLock
+ * @brief   Reader-writer lock built on two semaphores and os_sys_lock().
+ *          Any number of readers or one writer hold the lock. The state is
+ *          only touched inside os_sys_lock() and a releasing thread hands
+ *          the lock over to the threads it wakes, so a woken thread never
+ *          has to compete for it again.
+ *          By default readers get the lock while other readers hold it,
+ *          even with writers waiting. With OS_RWLOCK_FLAGS_WRITER_PREF a
+ *          waiting writer holds back new readers and goes first.
+ *  @note   Not recursive. With writer preference a thread that already
+ *          holds the read lock must not read lock again.
+ *
+ * @{
+ *===========================================================================*/
+
+#include "qoraal/config.h"
+#if !defined CFG_OS_RWLOCK_DISABLE
+#include "qoraal/qoraal.h"
+
+#if CFG_OS_STATIC_DECLARATIONS
+
+#define RWLOCK_WRITER           (-1)
+
+/*===========================================================================*/
+/* RWLock external declarations.                                             */
+/*===========================================================================*/
+
+int32_t
+os_rwlock_init (p_rwlock_t* rwlock, uint32_t flags)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    p_sem_t read_sem = (p_sem_t)&rw->read_sem ;
+    p_sem_t write_sem = (p_sem_t)&rw->write_sem ;
+
+    if (os_sem_init (&read_sem, 0) != EOK) {
+        return EFAIL ;
+    }
+    if (os_sem_init (&write_sem, 0) != EOK) {
+        os_sem_deinit (&read_sem) ;
+        return EFAIL ;
+    }
+    rw->active = 0 ;
+    rw->readers_waiting = 0 ;
+    rw->writers_waiting = 0 ;
+    rw->flags = flags ;
+
+    return EOK ;
+}
+
+void
+os_rwlock_deinit (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    p_sem_t read_sem = (p_sem_t)&rw->read_sem ;
+    p_sem_t write_sem = (p_sem_t)&rw->write_sem ;
+
+    os_sem_deinit (&read_sem) ;
+    os_sem_deinit (&write_sem) ;
+}
+
+int32_t
+os_rwlock_create (p_rwlock_t* rwlock, uint32_t flags)
+{
+    int32_t res ;
+
+    *(rwlock) = qoraal_malloc (QORAAL_HeapOperatingSystem, sizeof(os_rwlock_t)) ;
+    if (!*(rwlock)) return E_NOMEM ;
+    res = os_rwlock_init (rwlock, flags) ;
+    if (res != EOK) {
+        qoraal_free (QORAAL_HeapOperatingSystem, *(rwlock)) ;
+        *(rwlock) = 0 ;
+    }
+    return res ;
+}
+
+void
+os_rwlock_delete (p_rwlock_t* rwlock)
+{
+    os_rwlock_deinit (rwlock) ;
+    qoraal_free (QORAAL_HeapOperatingSystem, *(rwlock)) ;
+    *(rwlock) = 0 ;
+}
+
+/**
+ * @brief   Whether a new reader may take the lock now.
+ * @note    Called inside os_sys_lock().
+ *
+ * @notapi
+ */
+static inline int
+rwlock_read_ready (os_rwlock_t * rw)
+{
+    return (rw->active != RWLOCK_WRITER) &&
+            (!(rw->flags & OS_RWLOCK_FLAGS_WRITER_PREF) || !rw->writers_waiting) ;
+}
+
+/**
+ * @brief   Hands the lock over to waiting threads after it was released.
+ * @note    Called inside os_sys_lock(), with the lock free or read held.
+ *          Returns the number of readers to wake, -1 to wake a writer.
+ *
+ * @notapi
+ */
+static int32_t
+rwlock_handover (os_rwlock_t * rw)
+{
+    int32_t readers ;
+
+    if (rw->active == 0 && rw->writers_waiting &&
+            ((rw->flags & OS_RWLOCK_FLAGS_WRITER_PREF) || !rw->readers_waiting)) {
+        rw->writers_waiting-- ;
+        rw->active = RWLOCK_WRITER ;
+        return RWLOCK_WRITER ;
+    }
+
+    if (rw->readers_waiting && rwlock_read_ready (rw)) {
+        readers = rw->readers_waiting ;
+        rw->readers_waiting = 0 ;
+        rw->active += readers ;
+        return readers ;
+    }
+
+    return 0 ;
+}
+
+static void
+rwlock_wake (os_rwlock_t * rw, int32_t wake)
+{
+    p_sem_t read_sem = (p_sem_t)&rw->read_sem ;
+    p_sem_t write_sem = (p_sem_t)&rw->write_sem ;
+
+    if (wake == RWLOCK_WRITER) {
+        os_sem_signal (&write_sem) ;
+    } else {
+        while (wake--) {
+            os_sem_signal (&read_sem) ;
+        }
+    }
+}
+
+void
+os_rwlock_read_lock (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    p_sem_t read_sem = (p_sem_t)&rw->read_sem ;
+
+    os_sys_lock () ;
+    if (rwlock_read_ready (rw)) {
+        rw->active++ ;
+        os_sys_unlock () ;
+        return ;
+    }
+    rw->readers_waiting++ ;
+    os_sys_unlock () ;
+
+    /* the releasing thread counted us in active */
+    os_sem_wait (&read_sem) ;
+}
+
+int32_t
+os_rwlock_read_trylock (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    int32_t res = E_BUSY ;
+
+    os_sys_lock () ;
+    if (rwlock_read_ready (rw)) {
+        rw->active++ ;
+        res = EOK ;
+    }
+    os_sys_unlock () ;
+
+    return res ;
+}
+
+void
+os_rwlock_read_unlock (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    int32_t wake = 0 ;
+
+    os_sys_lock () ;
+    if (rw->active > 0) {
+        rw->active-- ;
+        wake = rwlock_handover (rw) ;
+    }
+    os_sys_unlock () ;
+
+    rwlock_wake (rw, wake) ;
+}
+
+void
+os_rwlock_write_lock (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    p_sem_t write_sem = (p_sem_t)&rw->write_sem ;
+
+    os_sys_lock () ;
+    if (rw->active == 0) {
+        rw->active = RWLOCK_WRITER ;
+        os_sys_unlock () ;
+        return ;
+    }
+    rw->writers_waiting++ ;
+    os_sys_unlock () ;
+
+    /* the releasing thread set active to RWLOCK_WRITER for us */
+    os_sem_wait (&write_sem) ;
+}
+
+int32_t
+os_rwlock_write_trylock (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    int32_t res = E_BUSY ;
+
+    os_sys_lock () ;
+    if (rw->active == 0) {
+        rw->active = RWLOCK_WRITER ;
+        res = EOK ;
+    }
+    os_sys_unlock () ;
+
+    return res ;
+}
+
+void
+os_rwlock_write_unlock (p_rwlock_t* rwlock)
+{
+    os_rwlock_t * rw = (os_rwlock_t *) *rwlock ;
+    int32_t wake = 0 ;
+
+    os_sys_lock () ;
+    if (rw->active == RWLOCK_WRITER) {
+        rw->active = 0 ;
+        wake = rwlock_handover (rw) ;
+    }
+    os_sys_unlock () ;
+
+    rwlock_wake (rw, wake) ;
+}
+
+#endif /* CFG_OS_STATIC_DECLARATIONS */
+
+#endif /* CFG_OS_RWLOCK_DISABLE */
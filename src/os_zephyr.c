@@ -201,6 +201,7 @@ os_zephyr_thread_common_init(os_zephyr_thread_t *thread)
     thread->errno_val = 0;
     thread->tls_bitmap = 0;
     thread->notify_value = 0;
+    atomic_set(&thread->notify_bits, 0);
     atomic_set(&thread->terminated, 0);
 }
 
@@ -328,6 +329,12 @@ os_sys_us_timestamp(void)
     return k_cyc_to_us_near32(k_cycle_get_32());
 }
 
+uint64_t
+os_sys_ns_timestamp(void)
+{
+    return k_ticks_to_ns_floor64(k_uptime_ticks());
+}
+
 void
 os_sys_stop(void)
 {
@@ -459,6 +466,36 @@ os_thread_get_name(p_thread_t *thread_handle)
     return thread->name;
 }
 
+int32_t
+os_thread_get_stats(p_thread_t *thread_handle, OS_THREAD_STATS_T *stats)
+{
+    os_zephyr_thread_t *thread = os_zephyr_thread_from_handle(thread_handle);
+    if (!thread) {
+        thread = os_zephyr_thread_get_current();
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (!thread) {
+        return E_PARM;
+    }
+
+    stats->stack_size = (uint32_t)thread->stack_size;
+#if defined(CONFIG_INIT_STACKS) && defined(CONFIG_THREAD_STACK_INFO)
+    size_t unused = 0;
+    if (k_thread_stack_space_get(&thread->thread, &unused) == 0) {
+        stats->stack_used = (uint32_t)(thread->thread.stack_info.size - unused);
+    }
+#endif
+#if defined(CONFIG_THREAD_RUNTIME_STATS)
+    k_thread_runtime_stats_t rt;
+    if (k_thread_runtime_stats_get(&thread->thread, &rt) == 0) {
+        stats->runtime_us = k_cyc_to_us_floor64(rt.execution_cycles);
+    }
+#endif
+
+    return EOK;
+}
+
 p_thread_t
 os_thread_current(void)
 {
@@ -656,6 +693,67 @@ os_thread_notify_isr(p_thread_t *thread_handle, int32_t msg)
     return os_thread_notify(thread_handle, msg);
 }
 
+/*
+ * The notification value is an atomic, notify_sem only wakes the thread.
+ * Shares notify_sem with os_thread_wait(), use one or the other.
+ */
+int32_t
+os_thread_notify_give(p_thread_t *thread_handle)
+{
+    os_zephyr_thread_t *thread = os_zephyr_thread_from_handle(thread_handle);
+    if (!thread) {
+        return E_PARM;
+    }
+
+    if (atomic_inc(&thread->notify_bits) == 0) {
+        k_sem_give(&thread->notify_sem);
+    }
+    return EOK;
+}
+
+int32_t
+os_thread_notify_bits(p_thread_t *thread_handle, uint32_t bits)
+{
+    os_zephyr_thread_t *thread = os_zephyr_thread_from_handle(thread_handle);
+    if (!thread) {
+        return E_PARM;
+    }
+
+    if (atomic_or(&thread->notify_bits, (atomic_val_t)bits) == 0) {
+        k_sem_give(&thread->notify_sem);
+    }
+    return EOK;
+}
+
+uint32_t
+os_thread_notify_take(uint32_t clear, uint32_t ticks)
+{
+    os_zephyr_thread_t *thread = os_zephyr_thread_get_current();
+    atomic_val_t value;
+
+    for (;;) {
+        value = atomic_get(&thread->notify_bits);
+        if (value) {
+            if (atomic_cas(&thread->notify_bits, value, clear ? 0 : value - 1)) {
+                return (uint32_t)value;
+            }
+            continue;
+        }
+        if (k_sem_take(&thread->notify_sem, os_zephyr_timeout_from_ticks(ticks)) != 0) {
+            return 0;
+        }
+    }
+}
+
+void
+os_thread_notify_clear(void)
+{
+    os_zephyr_thread_t *thread = os_zephyr_thread_get_current();
+
+    atomic_set(&thread->notify_bits, 0);
+    k_sem_reset(&thread->notify_sem);
+}
+
 /* -------------------------------------------------------------------------- */
 /* Mutexes                                                                    */
 /* -------------------------------------------------------------------------- */
@@ -725,6 +823,27 @@ os_mutex_trylock(p_mutex_t *mutex)
     return EFAIL;
 }
 
+int32_t
+os_mutex_get_stats(p_mutex_t *mutex, OS_MUTEX_STATS_T *stats)
+{
+    ARG_UNUSED(mutex);
+    ARG_UNUSED(stats);
+    return E_NOIMPL;
+}
+
+int32_t
+os_mutex_stats(p_mutex_stats_function_t fp, void *arg)
+{
+    ARG_UNUSED(fp);
+    ARG_UNUSED(arg);
+    return E_NOIMPL;
+}
+
+void
+os_mutex_reset_stats(void)
+{
+}
+
 /* -------------------------------------------------------------------------- */
 /* Counting semaphores                                                         */
 /* -------------------------------------------------------------------------- */
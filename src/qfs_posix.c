@@ -268,6 +268,11 @@ int qfs_rmdir(const char *path) {
     return -errno;
 }
 
+int qfs_rename(const char *from, const char *to) {
+    if (rename(from, to) == 0) return 0;
+    return -errno;
+}
+
 int qfs_match(const char *pattern, const char *name) {
 #if defined(_WIN32)
     /* fnmatch isn’t standard on Windows; you can stub or implement a
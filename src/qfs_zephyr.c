@@ -346,6 +346,16 @@ int qfs_rmdir(const char *path) {
     return fs_unlink(p);   // or fs_rmdir if your FS supports it
 }
 
+int qfs_rename(const char *from, const char *to) {
+    char f[QFS_PATH_MAX];
+    char t[QFS_PATH_MAX];
+    int rc = make_path(f, sizeof(f), from);
+    if (rc) return rc;
+    rc = make_path(t, sizeof(t), to);
+    if (rc) return rc;
+    return fs_rename(f, t);   // returns 0 or negative errno
+}
+
 // Minimal '*' and '?' wildcard matcher (no char classes, ranges, etc.)
 static int match_simple(const char *pat, const char *str) {
     const char *ps = NULL, *ss = NULL;
@@ -76,7 +76,7 @@ int qshell_uart_init(void) ;
 /*===========================================================================*/
 
 static bool                 _shell_exit = false ;
-static LOGGER_CHANNEL_T     _shell_log_channel = { .fp = console_logger_cb, .user = (void*)0, .filter = { { .mask = SVC_LOGGER_MASK, .type = SVC_LOGGER_SEVERITY_LOG | SVC_LOGGER_FLAGS_PROGRESS }, {0,0} } };
+static LOGGER_CHANNEL_T     _shell_log_channel = { .fp = console_logger_cb, .user = (void*)0, .name = "console", .filter = { { .mask = SVC_LOGGER_MASK, .type = SVC_LOGGER_SEVERITY_LOG | SVC_LOGGER_FLAGS_PROGRESS }, {0,0} } };
 
 /*===========================================================================*/
 /* Service Functions                                                         */
@@ -389,10 +389,9 @@ qshell_loglevel (SVC_SHELL_IF_T * pif, char** argv, int argc)
     if (argc > 1) {
 
         if (svc_shell_scan_int (argv[1], (uint32_t*)&val) == EOK) {
-            SVC_LOGGER_SET_SEVERITY(_shell_log_channel.filter[0].type, val) ;
-
-            svc_logger_channel_remove (&_shell_log_channel) ;
-            svc_logger_channel_add (&_shell_log_channel) ;
+            LOGGGER_CHANNEL_FILTER_T filter = _shell_log_channel.filter[0] ;
+            SVC_LOGGER_SET_SEVERITY(filter.type, val) ;
+            svc_logger_channel_set_filter (&_shell_log_channel, 0, filter) ;
         }
     }
 
@@ -31,16 +31,33 @@
 #include "qoraal/qoraal.h"
 #include "qoraal/svc/svc_services.h"
 #include "qoraal/svc/svc_shell.h"
+#include "qoraal/svc/svc_message.h"
 #include "qoraal/common/mlog.h"
 #include "qoraal/common/logit.h"
+#include "qoraal/common/logrec.h"
+#if !defined(CFG_QFS_DISABLE) || !CFG_QFS_DISABLE
+#include "qoraal/qfs.h"
+#include "qoraal/svc/svc_logfile.h"
+#endif
 
 SVC_SHELL_CMD_DECL("ctrl", qshell_cmd_ctrl, "[service name] [start/stop/restart] [arg]");
 SVC_SHELL_CMD_DECL( "logmsg", qshell_cmd_logmsg,  "<msg> [severity]" );
 SVC_SHELL_CMD_DECL( "sleep", qshell_cmd_sleep, "<msec>");
 SVC_SHELL_CMD_DECL( "cls", qshell_cmd_cls,  "");
+SVC_SHELL_CMD_DECL( "qstats", qshell_cmd_qstats,  "[reset]");
+SVC_SHELL_CMD_DECL( "lockstats", qshell_cmd_lockstats,  "[reset]");
+SVC_SHELL_CMD_DECL( "threads", qshell_cmd_threads,  "");
+SVC_SHELL_CMD_DECL( "wdt", qshell_cmd_wdt,  "");
 #if !defined CFG_COMMON_MEMLOG_DISABLE
 SVC_SHELL_CMD_DECL( "dmesg", qshell_cmd_dmesg,  "[severity] [count]");
 #endif
+#if !defined(CFG_QFS_DISABLE) || !CFG_QFS_DISABLE
+SVC_SHELL_CMD_DECL( "logfile", qshell_cmd_logfile,  "[<path> [max size] [max files] [severity]] [stop]");
+
+static SVC_LOGFILE_T        _shell_logfile ;
+static char                 _shell_logfile_path[QFS_PATH_MAX] ;
+static bool                 _shell_logfile_started = false ;
+#endif
 
 /**
  * @brief Sorting the Services in an alphabetic order
@@ -209,6 +226,184 @@ qshell_cmd_cls(SVC_SHELL_IF_T * pif, char** argv, int argc)
     return EOK ;
 }
 
+#define QSTATS_CHANNEL_HEADER   "  %-12s %9s %7s %4s  <16us  <64us <256us   <1ms   <4ms  <16ms  <65ms >=65ms  max(us)" SVC_SHELL_NEWLINE
+
+static void
+qstats_print_channel (SVC_SHELL_IF_T * pif, const char * name, int idx,
+        uint32_t delivered, uint32_t dropped, uint32_t high_water, const LATHIST_T * latency)
+{
+    char label[16] ;
+    int i ;
+
+    if (!name) {
+        snprintf (label, sizeof(label), "#%d", idx) ;
+        name = label ;
+    }
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-12s %9u %7u %4u",
+            name, (unsigned int)delivered, (unsigned int)dropped,
+            (unsigned int)high_water) ;
+    for (i=0; i<LATHIST_BUCKETS; i++) {
+        svc_shell_print (pif, SVC_SHELL_OUT_STD, " %6u",
+                (unsigned int)latency->bucket[i]) ;
+    }
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, " %8u" SVC_SHELL_NEWLINE,
+            (unsigned int)latency->max_us) ;
+}
+
+typedef struct QSTATS_ENUM_S {
+    SVC_SHELL_IF_T *    pif ;
+    int                 idx ;
+} QSTATS_ENUM_T ;
+
+static void
+qstats_logger_channel (void* arg, const LOGGER_CHANNEL_T* channel, const SVC_LOGGER_CHANNEL_STATS_T* stats)
+{
+    QSTATS_ENUM_T * e = (QSTATS_ENUM_T *) arg ;
+    qstats_print_channel (e->pif, channel->name, e->idx++, stats->delivered,
+            stats->dropped, stats->high_water, &stats->latency) ;
+}
+
+static void
+qstats_message_channel (void * arg, const SVC_MESSAGE_CHANNEL_T * channel, const SVC_MESSAGE_CHANNEL_STATS_T * stats)
+{
+    QSTATS_ENUM_T * e = (QSTATS_ENUM_T *) arg ;
+    qstats_print_channel (e->pif, channel->name, e->idx++, stats->delivered,
+            0, 0, &stats->latency) ;
+}
+
+static int32_t
+qshell_cmd_qstats (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    SVC_LOGGER_STATS_T logger ;
+    SVC_MESSAGE_STATS_T message ;
+    QSTATS_ENUM_T e = { pif, 0 } ;
+
+    if ((argc > 1) && (strcmp (argv[1], "reset") == 0)) {
+        svc_logger_reset_stats () ;
+        svc_message_reset_stats () ;
+        return SVC_SHELL_CMD_E_OK ;
+
+    }
+
+    svc_logger_get_stats (&logger) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD,
+            "logger: %u enqueued, %u dropped, high water %u/%u" SVC_SHELL_NEWLINE
+            "        %u formatted, %u truncated, %u deduplicated, %u rate limited" SVC_SHELL_NEWLINE,
+            (unsigned int)logger.enqueued, (unsigned int)logger.dropped,
+            (unsigned int)logger.high_water, SVC_LOGGER_MAX_QUEUE_SIZE,
+            (unsigned int)logger.formatted, (unsigned int)logger.truncated,
+            (unsigned int)logger.deduplicated, (unsigned int)logger.ratelimited) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, QSTATS_CHANNEL_HEADER,
+            "channel", "delivered", "dropped", "hwm") ;
+    svc_logger_channel_stats (qstats_logger_channel, &e) ;
+
+    svc_message_get_stats (&message) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD,
+            "message: %u posted, %u dropped, %u delivered, %u queued, high water %u/%u" SVC_SHELL_NEWLINE,
+            (unsigned int)message.posted, (unsigned int)message.dropped,
+            (unsigned int)message.delivered, (unsigned int)message.queued,
+            (unsigned int)message.high_water, SVC_MESSAGE_MAX_QUEUE_SIZE) ;
+    e.idx = 0 ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, QSTATS_CHANNEL_HEADER,
+            "channel", "delivered", "dropped", "hwm") ;
+    svc_message_channel_stats (qstats_message_channel, &e) ;
+
+    return SVC_SHELL_CMD_E_OK ;
+}
+
+static void
+lockstats_mutex (void * arg, const char * name, p_mutex_t mutex, const OS_MUTEX_STATS_T * stats)
+{
+    SVC_SHELL_IF_T * pif = (SVC_SHELL_IF_T *) arg ;
+    char label[24] ;
+
+    if (!name) {
+        snprintf (label, sizeof(label), "%p", mutex) ;
+        name = label ;
+    }
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-22s %10u %9u %7u %10u %8u" SVC_SHELL_NEWLINE,
+            name, (unsigned int)stats->locks, (unsigned int)stats->contended,
+            (unsigned int)stats->spun, (unsigned int)(stats->wait_ns / 1000ULL),
+            (unsigned int)stats->max_wait_us) ;
+}
+
+static int32_t
+qshell_cmd_lockstats (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    if ((argc > 1) && (strcmp (argv[1], "reset") == 0)) {
+        os_mutex_reset_stats () ;
+        return SVC_SHELL_CMD_E_OK ;
+
+    }
+
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-22s %10s %9s %7s %10s %8s" SVC_SHELL_NEWLINE,
+            "mutex", "locks", "contended", "spun", "wait(us)", "max(us)") ;
+    if (os_mutex_stats (lockstats_mutex, pif) != EOK) {
+        svc_shell_print (pif, SVC_SHELL_OUT_STD, "not supported" SVC_SHELL_NEWLINE) ;
+        return SVC_SHELL_CMD_E_NOT_IMPL ;
+
+    }
+
+    return SVC_SHELL_CMD_E_OK ;
+}
+
+static void
+threads_thread (void * arg, SVC_THREADS_T * thread)
+{
+    SVC_SHELL_IF_T * pif = (SVC_SHELL_IF_T *) arg ;
+    OS_THREAD_STATS_T stats ;
+
+    os_thread_get_stats (&thread->thread, &stats) ;
+    /* measured in whole pages on some ports */
+    if (stats.stack_used > stats.stack_size) {
+        stats.stack_used = stats.stack_size ;
+    }
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-22s %18p %8u %8u %10u" SVC_SHELL_NEWLINE,
+            thread->name ? thread->name : "", thread->thread,
+            (unsigned int)stats.stack_size, (unsigned int)stats.stack_used,
+            (unsigned int)(stats.runtime_us / 1000ULL)) ;
+}
+
+static int32_t
+qshell_cmd_threads (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    uint32_t count ;
+
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-22s %18s %8s %8s %10s" SVC_SHELL_NEWLINE,
+            "thread", "handle", "stack", "used", "cpu(ms)") ;
+    count = svc_threads_enum (threads_thread, pif) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "%u threads" SVC_SHELL_NEWLINE,
+            (unsigned int)count) ;
+
+    return SVC_SHELL_CMD_E_OK ;
+}
+
+static void
+wdt_handler (void * arg, SVC_WDT_HANDLE_T * handler)
+{
+    SVC_SHELL_IF_T * pif = (SVC_SHELL_IF_T *) arg ;
+
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-22s %18p %10u %10u %s" SVC_SHELL_NEWLINE,
+            os_thread_get_name (&handler->thread), (void*)handler->id,
+            (unsigned int)svc_wdt_timeout_ms (handler),
+            (unsigned int)svc_wdt_max_interval (handler),
+            handler->active ? "active" : "") ;
+}
+
+static int32_t
+qshell_cmd_wdt (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    uint32_t count ;
+
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "  %-22s %18s %10s %10s" SVC_SHELL_NEWLINE,
+            "thread", "id", "timeout", "max(ms)") ;
+    count = svc_wdt_enum (wdt_handler, pif) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "%u handlers" SVC_SHELL_NEWLINE,
+            (unsigned int)count) ;
+
+    return SVC_SHELL_CMD_E_OK ;
+}
+
 #if !defined CFG_COMMON_MEMLOG_DISABLE
 static int32_t 
 qshell_cmd_dmesg (SVC_SHELL_IF_T * pif, char** argv, int argc)
@@ -237,20 +432,35 @@ qshell_cmd_dmesg (SVC_SHELL_IF_T * pif, char** argv, int argc)
             severity) ;
 
     if (it) {
-        while (cnt && (it->get (it, msg, LOG_MSG_SIZE) >= EOK)) {
+        int32_t len ;
+        while (cnt && ((len = it->get (it, msg, LOG_MSG_SIZE)) >= EOK)) {
 
             if (msg->severity <= severity) {
-
+                RTCLIB_DATE_T date ;
+                RTCLIB_TIME_T time ;
+                char fields[96] ;
+                int32_t text = strlen (msg->msg) + 1 ;
+
+                /* a structured record follows the message terminator */
+                len -= sizeof(QORAAL_LOG_MSG_T) ;
+                if (len > msg->len) len = msg->len ;
+                fields[0] = '\0' ;
+                if (len > text) {
+                    logrec_render (fields, sizeof(fields),
+                            (const uint8_t*)&msg->msg[text], len - text) ;
+                }
+
+                rtc_localtime (msg->seconds, &date, &time) ;
                 svc_shell_print (pif, SVC_SHELL_OUT_STD,
                         "%.6d (%d) - "
                         "%.4d-%.2d-%.2d "
                         "%.2d:%.2d:%.2d:  "
-                        "%s\r\n" ,
+                        "%s%s\r\n" ,
                         msg->id,
                         msg->severity,
-                        msg->date.year, msg->date.month, msg->date.day,
-                        msg->time.hour, msg->time.minute, msg->time.second,
-                        msg->msg) ;
+                        date.year, date.month, date.day,
+                        time.hour, time.minute, time.second,
+                        msg->msg, fields) ;
 
                 cnt-- ;
 
@@ -269,6 +479,77 @@ qshell_cmd_dmesg (SVC_SHELL_IF_T * pif, char** argv, int argc)
 }
 #endif
 
+#if !defined(CFG_QFS_DISABLE) || !CFG_QFS_DISABLE
+static int32_t
+qshell_cmd_logfile (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    SVC_LOGFILE_CFG_T cfg = { .path = _shell_logfile_path,
+                              .max_files = 3,
+                              .flush_severity = SVC_LOGGER_SEVERITY_ERROR } ;
+    LOGGGER_CHANNEL_FILTER_T filter = { SVC_LOGGER_MASK, SVC_LOGGER_SEVERITY_LOG } ;
+    SVC_LOGFILE_STATS_T stats ;
+    uint32_t value ;
+    int32_t res ;
+
+    if (argc < 2) {
+        if (!_shell_logfile_started) {
+            svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                    "not logging to file" SVC_SHELL_NEWLINE) ;
+            return SVC_SHELL_CMD_E_OK ;
+
+        }
+        svc_logfile_get_stats (&_shell_logfile, &stats) ;
+        svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                "%s: %u bytes written, %u dropped, %u rotations, %u errors"
+                SVC_SHELL_NEWLINE,
+                _shell_logfile_path, (unsigned int)stats.written,
+                (unsigned int)stats.dropped, (unsigned int)stats.rotations,
+                (unsigned int)stats.errors) ;
+        return SVC_SHELL_CMD_E_OK ;
+
+    }
+
+    if (_shell_logfile_started) {
+        svc_logfile_stop (&_shell_logfile) ;
+        _shell_logfile_started = false ;
+
+    }
+    if (strcmp (argv[1], "stop") == 0) {
+        return SVC_SHELL_CMD_E_OK ;
+
+    }
+
+    qfs_make_abs (_shell_logfile_path, sizeof(_shell_logfile_path), argv[1]) ;
+    if ((argc > 2) && (svc_shell_scan_int (argv[2], &value) == EOK)) {
+        cfg.max_size = value ;
+    }
+    if ((argc > 3) && (svc_shell_scan_int (argv[3], &value) == EOK)) {
+        cfg.max_files = value ;
+    }
+    if ((argc > 4) && (svc_shell_scan_int (argv[4], &value) == EOK)) {
+        filter.type = value ;
+    }
+
+    /* svc_threads releases the writer of a file just stopped shortly after */
+    for (value = 0 ; value < 100 ; value++) {
+        res = svc_logfile_start (&_shell_logfile, &cfg, filter) ;
+        if (res != E_BUSY) {
+            break ;
+        }
+        os_thread_sleep (10) ;
+    }
+    if (res != EOK) {
+        svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                "failed %d" SVC_SHELL_NEWLINE, res) ;
+        return SVC_SHELL_CMD_E_FAIL ;
+
+    }
+    _shell_logfile_started = true ;
+
+    return SVC_SHELL_CMD_E_OK ;
+}
+#endif
+
 /* This function exists only to force this module into any final binary
  * that wants shell commands. It does nothing at runtime.
  */
@@ -0,0 +1,349 @@
+/*
+    Copyright (C) 2015-2025, Navaro, All Rights Reserved
+    SPDX-License-Identifier: MIT
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+
+#include "qoraal/config.h"
+#if !defined(CFG_QFS_DISABLE) || !CFG_QFS_DISABLE
+
+#include <stdio.h>
+#include <string.h>
+#include "qoraal/qoraal.h"
+#include "qoraal/qfs.h"
+#include "qoraal/svc/svc_logfile.h"
+
+
+/**
+ * @brief   Moves path.N-1 to path.N, down to path to path.1.
+ *
+ * @notapi
+ */
+static void
+logfile_rotate (SVC_LOGFILE_T * logfile)
+{
+    char from[QFS_PATH_MAX] ;
+    char to[QFS_PATH_MAX] ;
+    int i ;
+
+    if (!logfile->cfg.max_files) {
+        qfs_unlink (logfile->cfg.path) ;
+        return ;
+
+    }
+
+    snprintf (to, sizeof(to), "%s.%u", logfile->cfg.path, logfile->cfg.max_files) ;
+    qfs_unlink (to) ;
+    for (i=logfile->cfg.max_files-1; i>0; i--) {
+        snprintf (from, sizeof(from), "%s.%u", logfile->cfg.path, i) ;
+        qfs_rename (from, to) ;
+        strcpy (to, from) ;
+    }
+    qfs_rename (logfile->cfg.path, to) ;
+
+    logfile->stats.rotations++ ;
+}
+
+/**
+ * @brief   Writes up to len buffered bytes to the file, rotating it first if
+ *          they would take it past max_size.
+ *
+ * @return              bytes taken from the buffer.
+ *
+ * @notapi
+ */
+static uint32_t
+logfile_write (SVC_LOGFILE_T * logfile, qfs_file_t ** file, uint32_t len)
+{
+    uint32_t tail ;
+    int res ;
+
+    os_sys_lock () ;
+    tail = (logfile->head + logfile->cfg.buffer_size - logfile->count) % logfile->cfg.buffer_size ;
+    os_sys_unlock () ;
+
+    if (len > logfile->cfg.buffer_size - tail) {
+        len = logfile->cfg.buffer_size - tail ;
+    }
+
+    if (*file && logfile->cfg.max_size &&
+            (logfile->file_size + len > logfile->cfg.max_size)) {
+        qfs_close (*file) ;
+        *file = 0 ;
+        logfile_rotate (logfile) ;
+        logfile->file_size = 0 ;
+
+    }
+
+    if (!*file && (qfs_open (file, logfile->cfg.path, QFS_OPEN_APPEND) < 0)) {
+        *file = 0 ;
+
+    }
+
+    res = *file ? qfs_write (*file, &logfile->buffer[tail], len) : -1 ;
+    if (res < 0) {
+        logfile->stats.errors++ ;
+
+    } else {
+        logfile->file_size += res ;
+        logfile->stats.written += res ;
+
+    }
+
+    /* what could not be written is dropped, the buffer must keep moving */
+    os_sys_lock () ;
+    logfile->count -= len ;
+    os_sys_unlock () ;
+
+    return len ;
+}
+
+/**
+ * @brief   Writer thread. Writes whole blocks as they fill up and everything
+ *          buffered when urgent or after flush_ms.
+ *
+ * @notapi
+ */
+static void
+logfile_thread (void * arg)
+{
+    SVC_LOGFILE_T * logfile = (SVC_LOGFILE_T *) arg ;
+    qfs_file_t * file = 0 ;
+    uint32_t timeout = OS_MS2TICKS(logfile->cfg.flush_ms) ;
+    uint32_t all ;
+
+    /* a new file for every start when the previous one can be kept as
+       path.1, otherwise append to it */
+    if (logfile->cfg.max_size && logfile->cfg.max_files) {
+        logfile_rotate (logfile) ;
+    }
+
+    while (!logfile->stop) {
+        if (logfile->count) {
+            all = os_sem_wait_timeout (&logfile->sem, timeout) != EOK ;
+        } else {
+            os_sem_wait (&logfile->sem) ;
+            all = 0 ;
+        }
+
+        if (logfile->urgent || logfile->stop) {
+            logfile->urgent = 0 ;
+            all = 1 ;
+        }
+
+        while (logfile->count && (all || (logfile->count >= logfile->cfg.block_size))) {
+            logfile_write (logfile, &file,
+                    logfile->count < logfile->cfg.block_size ?
+                            logfile->count : logfile->cfg.block_size) ;
+        }
+
+    }
+
+    if (file) {
+        qfs_close (file) ;
+    }
+
+    os_sem_signal (&logfile->stopped) ;
+}
+
+/**
+ * @brief   Logger channel callback, copies the message into the buffer.
+ * @note    Never waits on the file system. A message that does not fit is
+ *          dropped and the writer is woken up.
+ *
+ * @notapi
+ */
+static void
+logfile_channel (void* channel, LOGGER_TYPE_T type, uint8_t facility, const char* msg)
+{
+    SVC_LOGFILE_T * logfile = (SVC_LOGFILE_T *) channel ;
+    uint32_t newline = (type & SVC_LOGGER_FLAGS_NO_FORMATTING) ? 0 : 1 ;
+    uint32_t len = strlen (msg) ;
+    uint32_t size = logfile->cfg.buffer_size ;
+    uint32_t head = logfile->head ;
+    uint32_t count ;
+    uint32_t first ;
+
+    (void)facility ;
+
+    os_sys_lock () ;
+    count = logfile->count ;
+    os_sys_unlock () ;
+
+    if (count + len + newline > size) {
+        OS_ATOMIC_INC (&logfile->stats.dropped) ;
+        logfile->urgent = 1 ;
+        os_sem_signal (&logfile->sem) ;
+        return ;
+
+    }
+
+    /* the writer only reads below count, so the free space is ours */
+    first = size - head ;
+    if (first > len) first = len ;
+    memcpy (&logfile->buffer[head], msg, first) ;
+    memcpy (logfile->buffer, &msg[first], len - first) ;
+    head = (head + len) % size ;
+    if (newline) {
+        logfile->buffer[head] = '\n' ;
+        head = (head + 1) % size ;
+    }
+
+    os_sys_lock () ;
+    logfile->head = head ;
+    logfile->count += len + newline ;
+    count = logfile->count ;
+    os_sys_unlock () ;
+
+    if (SVC_LOGGER_GET_SEVERITY(type) <= logfile->cfg.flush_severity) {
+        logfile->urgent = 1 ;
+        os_sem_signal (&logfile->sem) ;
+
+    } else if ((count == len + newline) ||
+            ((count >= logfile->cfg.block_size) &&
+             (count - len - newline < logfile->cfg.block_size))) {
+        /* first bytes start the flush interval, a full block is written now */
+        os_sem_signal (&logfile->sem) ;
+
+    }
+}
+
+/**
+ * @brief   Starts logging to a file.
+ * @note    Returns E_BUSY while svc_threads still holds the writer thread
+ *          of a previous start.
+ *
+ * @param[in] logfile       caller allocated, zeroed before the first start
+ * @param[in] cfg           configuration, path must remain valid
+ * @param[in] filter        filter for the logger channel
+ *
+ * @return              Error.
+ *
+ * @svc
+ */
+int32_t
+svc_logfile_start (SVC_LOGFILE_T * logfile, const SVC_LOGFILE_CFG_T * cfg, LOGGGER_CHANNEL_FILTER_T filter)
+{
+    int32_t res ;
+
+    if (!cfg || !cfg->path) {
+        return E_PARM ;
+    }
+    if (svc_threads_is_active (&logfile->thread)) {
+        return E_BUSY ;
+    }
+
+    memset (logfile, 0, sizeof(SVC_LOGFILE_T)) ;
+    logfile->cfg = *cfg ;
+    if (!logfile->cfg.buffer_size) logfile->cfg.buffer_size = SVC_LOGFILE_BUFFER_SIZE ;
+    if (!logfile->cfg.block_size) logfile->cfg.block_size = SVC_LOGFILE_BLOCK_SIZE ;
+    if (!logfile->cfg.flush_ms) logfile->cfg.flush_ms = SVC_LOGFILE_FLUSH_MS ;
+    if (logfile->cfg.block_size > logfile->cfg.buffer_size / 2) {
+        logfile->cfg.block_size = logfile->cfg.buffer_size / 2 ;
+    }
+
+    logfile->buffer = qoraal_malloc (QORAAL_HeapAuxiliary, logfile->cfg.buffer_size) ;
+    if (!logfile->buffer) {
+        return E_NOMEM ;
+    }
+    if (os_sem_create (&logfile->sem, 0) != EOK) {
+        qoraal_free (QORAAL_HeapAuxiliary, logfile->buffer) ;
+        return E_NOMEM ;
+    }
+    if (os_sem_create (&logfile->stopped, 0) != EOK) {
+        os_sem_delete (&logfile->sem) ;
+        qoraal_free (QORAAL_HeapAuxiliary, logfile->buffer) ;
+        return E_NOMEM ;
+    }
+
+    res = svc_threads_create (&logfile->thread, 0,
+                SVC_LOGFILE_STACK_SIZE, SVC_LOGFILE_PRIO, logfile_thread,
+                logfile, "logfile") ;
+    if (res != EOK) {
+        os_sem_delete (&logfile->sem) ;
+        os_sem_delete (&logfile->stopped) ;
+        qoraal_free (QORAAL_HeapAuxiliary, logfile->buffer) ;
+        return res ;
+    }
+
+    logfile->channel.fp = logfile_channel ;
+    logfile->channel.user = logfile ;
+    logfile->channel.name = "logfile" ;
+    logfile->channel.filter[0] = filter ;
+    svc_logger_channel_add (&logfile->channel) ;
+
+    return EOK ;
+}
+
+/**
+ * @brief   Stops logging to the file after writing out what was buffered.
+ *
+ * @param[in] logfile
+ *
+ * @svc
+ */
+void
+svc_logfile_stop (SVC_LOGFILE_T * logfile)
+{
+    svc_logger_channel_remove (&logfile->channel) ;
+
+    logfile->stop = 1 ;
+    os_sem_signal (&logfile->sem) ;
+    os_sem_wait (&logfile->stopped) ;
+
+    os_sem_delete (&logfile->sem) ;
+    os_sem_delete (&logfile->stopped) ;
+    qoraal_free (QORAAL_HeapAuxiliary, logfile->buffer) ;
+    logfile->buffer = 0 ;
+}
+
+/**
+ * @brief   Has the writer write out everything buffered.
+ * @note    Does not wait for the write to complete.
+ *
+ * @param[in] logfile
+ *
+ * @svc
+ */
+void
+svc_logfile_flush (SVC_LOGFILE_T * logfile)
+{
+    logfile->urgent = 1 ;
+    os_sem_signal (&logfile->sem) ;
+}
+
+/**
+ * @brief   Returns the file channel statistics.
+ *
+ * @param[in] logfile
+ * @param[out] stats
+ *
+ * @svc
+ */
+void
+svc_logfile_get_stats (SVC_LOGFILE_T * logfile, SVC_LOGFILE_STATS_T * stats)
+{
+    os_sys_lock () ;
+    *stats = logfile->stats ;
+    os_sys_unlock () ;
+}
+
+#endif /* CFG_QFS_DISABLE */
@@ -46,23 +46,94 @@ static LOGGGER_CHANNEL_FILTER_T     _logger_filter =  {SVC_LOGGER_MASK, SVC_LOGG
 static LOGGGER_CHANNEL_FILTER_T     _logger_filter_mem = {SVC_LOGGER_MASK, SVC_LOGGER_SEVERITY_LOG} ;
 #endif
 
+/*
+ * Two gate tables, the inactive one is rebuilt and then published with a
+ * single pointer store so readers never see a half updated table. Until the
+ * first channel is registered everything passes the gate.
+ */
+static uint8_t              _logger_gate_table[2][SVC_LOGGER_FACILITY_CNT] = {
+        { [0 ... SVC_LOGGER_FACILITY_CNT-1] = SVC_LOGGER_SEVERITY_DEBUG }
+    } ;
+const uint8_t * volatile    svc_logger_gate = _logger_gate_table[0] ;
+
 static SVC_TASK_PRIO_T      _logger_task_prio ;
 static uint16_t             _logger_id = 0 ;
 static int32_t              _logger_debug_sending = 0 ;
+static int32_t              _logger_channel_pending = 0 ;
+static SVC_LOGGER_STATS_T   _logger_stats = {0} ;
+static uint32_t             _logger_scratch_used = 0 ;
+static char                 _logger_scratch[SVC_LOGGER_FORMAT_BUFFER_CNT][SVC_LOGGER_FORMAT_BUFFER_SIZE] ;
 
 static LISTS_LINKED_DECL    (_logger_channels) ;
 static OS_MUTEX_DECL        (_logger_mutex) ;
 
 #define LOG_MESSAGE_SIZE    0
 typedef struct LOGGER_TASK_S {
-    SVC_TASKS_T             task ;
+    struct LOGGER_TASK_S *  next ;
+    struct LOGGER_TASK_S *  more ;      /**< next part of a message split up, queued with it */
     LOGGER_TYPE_T          type ;
     uint8_t                 facility ;
-    uint8_t                 reserved ;
+    uint8_t                 refs ;
     uint16_t                id ;
+    uint16_t                len ;       /**< message length, the record follows its terminator */
+    uint16_t                record ;    /**< record length, see logrec.h */
+    uint64_t                timestamp ;
     char                    message[0] ;
 } LOGGER_TASK_T ;
 
+typedef struct LOGGER_QUEUE_ENTRY_S {
+    LOGGER_TASK_T *         task ;
+    uint16_t                offset ;
+} LOGGER_QUEUE_ENTRY_T ;
+
+typedef struct LOGGER_CHANNEL_QUEUE_S {
+    SVC_TASKS_T             task ;
+    LOGGER_CHANNEL_T *      channel ;
+    uint16_t                size ;
+    uint16_t                head ;
+    uint16_t                count ;
+    uint16_t                reserved ;
+    LOGGER_QUEUE_ENTRY_T    entries[] ;
+} LOGGER_CHANNEL_QUEUE_T ;
+
+/*
+ * The last message formatted, identified by a hash of its text without the
+ * timestamp prefix. Identical messages that follow only bump repeats.
+ */
+typedef struct LOGGER_DEDUP_S {
+    uint32_t                hash ;
+    uint32_t                start ;
+    uint32_t                repeats ;
+    LOGGER_TYPE_T           type ;
+    uint8_t                 facility ;
+} LOGGER_DEDUP_T ;
+
+static LOGGER_DEDUP_T       _logger_dedup = {0} ;
+
+/*
+ * Messages wait in one queue per severity class, ERROR and ASSERT, WARNING
+ * and REPORT, and the rest, and are delivered highest class first. The
+ * lower classes may not take the queue entries reserved for the higher.
+ */
+#define LOGGER_CLASS_CNT    3
+
+typedef struct LOGGER_CLASS_QUEUE_S {
+    LOGGER_TASK_T *         head ;
+    LOGGER_TASK_T *         tail ;
+} LOGGER_CLASS_QUEUE_T ;
+
+static LOGGER_CLASS_QUEUE_T _logger_class_queue[LOGGER_CLASS_CNT] ;
+static const int32_t        _logger_class_limit[LOGGER_CLASS_CNT] = {
+        SVC_LOGGER_MAX_QUEUE_SIZE,
+        SVC_LOGGER_MAX_QUEUE_SIZE - SVC_LOGGER_RESERVED_ERROR,
+        SVC_LOGGER_MAX_QUEUE_SIZE - SVC_LOGGER_RESERVED_ERROR - SVC_LOGGER_RESERVED_WARNING
+    } ;
+static SVC_TASKS_DECL       (_logger_dispatch_task) ;
+
+static void     logger_gate_update (void) ;
+static char *   logger_scratch_get (void) ;
+static void     logger_scratch_put (char * buffer) ;
+
 
 __attribute__((weak))  char __memlog_base__;
 __attribute__((weak))  char __memlog_end__;
@@ -79,6 +150,8 @@ svc_logger_init (SVC_TASK_PRIO_T  prio)
 {
     os_mutex_init (&_logger_mutex) ;
     linked_init (&_logger_channels) ;
+    svc_tasks_init_task (&_logger_dispatch_task) ;
+    memset (_logger_class_queue, 0, sizeof(_logger_class_queue)) ;
 
     _logger_task_prio = prio ;
 
@@ -94,6 +167,10 @@ svc_logger_init (SVC_TASK_PRIO_T  prio)
 
     }
 
+    os_mutex_lock (&_logger_mutex) ;
+    logger_gate_update () ;
+    os_mutex_unlock (&_logger_mutex) ;
+
     return EOK ;
 }
 
@@ -112,20 +189,232 @@ svc_logger_start (void)
 
 
 /**
-* @brief   SVC Task callback to send log message to the registered log channels.
+* @brief   Drops a reference to the log message, the last one frees it.
+*
+* @notapi
+*/
+static void
+logger_task_release (LOGGER_TASK_T *logger_task)
+{
+    uint8_t refs ;
+
+    os_sys_lock();
+    refs = --logger_task->refs ;
+    os_sys_unlock();
+
+    if (!refs) {
+        qoraal_free(QORAAL_HeapAuxiliary, logger_task) ;
+    }
+}
+
+static uint32_t
+logger_class (LOGGER_TYPE_T type)
+{
+    uint32_t severity = SVC_LOGGER_GET_SEVERITY(type) ;
+
+    if (severity <= SVC_LOGGER_SEVERITY_ERROR) return 0 ;
+    if (severity <= SVC_LOGGER_SEVERITY_REPORT) return 1 ;
+    return 2 ;
+}
+
+/**
+* @brief   Checks for room in the queue of the severity class of type,
+*          before the work of formatting a message.
+*
+* @notapi
+*/
+static uint32_t
+logger_full (LOGGER_TYPE_T type)
+{
+    return _logger_debug_sending >= _logger_class_limit[logger_class (type)] ;
+}
+
+static LOGGER_TASK_T *
+logger_dequeue (void)
+{
+    LOGGER_TASK_T * task = 0 ;
+    int i ;
+
+    os_sys_lock();
+    for (i=0; i<LOGGER_CLASS_CNT; i++) {
+        task = _logger_class_queue[i].head ;
+        if (task) {
+            _logger_class_queue[i].head = task->next ;
+            if (!task->next) {
+                _logger_class_queue[i].tail = 0 ;
+            }
+            break ;
+        }
+    }
+    os_sys_unlock();
+
+    return task ;
+}
+
+static void
+logger_dropped (void)
+{
+    /* logger_enqueue() counts drops under the lock too */
+    os_sys_lock();
+    _logger_stats.dropped++ ;
+    os_sys_unlock();
+}
+
+static uint32_t
+logger_queue_pop (LOGGER_CHANNEL_QUEUE_T * queue, LOGGER_QUEUE_ENTRY_T * entry)
+{
+    uint32_t res = 0 ;
+
+    os_sys_lock();
+    if (queue->count) {
+        *entry = queue->entries[queue->head] ;
+        queue->head = (queue->head + 1) % queue->size ;
+        queue->count-- ;
+        _logger_channel_pending-- ;
+        res = 1 ;
+    }
+    os_sys_unlock();
+
+    return res ;
+}
+
+/**
+* @brief   Passes a message to a channel.
+* @note    Channels with a record callback get the message and its binary
+*          record as is. Other channels get the record rendered as
+*          " key=value" text after the message. Counts the delivery and
+*          its latency in the channel statistics.
+*
+* @param[in] channel       channel
+* @param[in] task          message
+* @param[in] offset        start of the message text
+*
+* @notapi
+*/
+static void
+logger_deliver (LOGGER_CHANNEL_T * channel, LOGGER_TASK_T * task, uint16_t offset)
+{
+    const char * msg = (const char*)&task->message[offset] ;
+    const uint8_t * record = (const uint8_t*)&task->message[task->len + 1] ;
+    char * scratch ;
+    uint32_t len ;
+
+    if (channel->record) {
+        channel->record (channel, task->type, task->facility, msg,
+                task->record ? record : 0, task->record) ;
+
+    } else if (!task->record || !(scratch = logger_scratch_get ())) {
+        channel->fp (channel, task->type, task->facility, msg) ;
+
+    } else {
+        len = task->len - offset ;
+#if SVC_LOGGER_APPEND_CRLF
+        len -= 2 ;
+#endif
+        if (len > SVC_LOGGER_FORMAT_BUFFER_SIZE - 3) {
+            len = SVC_LOGGER_FORMAT_BUFFER_SIZE - 3 ;
+        }
+        memcpy (scratch, msg, len) ;
+        len += logrec_render (&scratch[len], SVC_LOGGER_FORMAT_BUFFER_SIZE - 2 - len,
+                record, task->record) ;
+#if SVC_LOGGER_APPEND_CRLF
+        strcpy (&scratch[len], "\r\n") ;
+#endif
+        channel->fp (channel, task->type, task->facility, scratch) ;
+        logger_scratch_put (scratch) ;
+
+    }
+
+    len = (uint32_t)((os_sys_ns_timestamp () - task->timestamp) / 1000ULL) ;
+    os_sys_lock();
+    channel->stats.delivered++ ;
+    lathist_add (&channel->stats.latency, len) ;
+    os_sys_unlock();
+}
+
+/**
+* @brief   SVC Task callback draining the queue of an asynchronous channel.
 *
 * @param[in] task
 * @param[in] parm
 * @param[in] reason
 *
-* @return              Error.
+* @notapi
+*/
+static void
+logger_queue_callback (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
+{
+    LOGGER_CHANNEL_QUEUE_T * queue = (LOGGER_CHANNEL_QUEUE_T*) task ;
+    LOGGER_QUEUE_ENTRY_T entry ;
+
+    while (logger_queue_pop (queue, &entry)) {
+        if (reason == SERVICE_CALLBACK_REASON_RUN) {
+            logger_deliver (queue->channel, entry.task, entry.offset) ;
+        }
+        logger_task_release (entry.task) ;
+    }
+
+    svc_tasks_complete (task) ;
+}
+
+/**
+* @brief   Queues the log message for an asynchronous channel, applying the
+*          channel overflow policy when it is full.
 *
 * @notapi
 */
 static void
-logger_task_callback (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
+logger_queue_push (LOGGER_CHANNEL_QUEUE_T * queue, LOGGER_TASK_T *logger_task, uint16_t offset)
 {
-    LOGGER_TASK_T *logger_task = (LOGGER_TASK_T*) task ;
+    LOGGER_TASK_T * dropped = 0 ;
+    uint16_t tail ;
+
+    os_sys_lock();
+    if (queue->count >= queue->size) {
+        queue->channel->stats.dropped++ ;
+        if (queue->channel->overflow != SVC_LOGGER_OVERFLOW_DROP_OLDEST) {
+            os_sys_unlock();
+            return ;
+        }
+        dropped = queue->entries[queue->head].task ;
+        queue->head = (queue->head + 1) % queue->size ;
+        queue->count-- ;
+        _logger_channel_pending-- ;
+    }
+    tail = (queue->head + queue->count) % queue->size ;
+    queue->entries[tail].task = logger_task ;
+    queue->entries[tail].offset = offset ;
+    queue->count++ ;
+    if (queue->count > queue->channel->stats.high_water) {
+        queue->channel->stats.high_water = queue->count ;
+    }
+    _logger_channel_pending++ ;
+    logger_task->refs++ ;
+    os_sys_unlock();
+
+    if (dropped) {
+        logger_task_release (dropped) ;
+    }
+
+    /* E_BUSY when the drain task is already queued. */
+    svc_tasks_schedule (&queue->task, logger_queue_callback, 0, queue->channel->prio, 0) ;
+}
+
+/**
+* @brief   Sends a log message to the registered log channels.
+* @note    Channels with a queue are only handed a reference here and are
+*          called from their own drain task.
+*
+* @param[in] logger_task   message
+* @param[in] reason        reason of the dispatch task callback
+*
+* @notapi
+*/
+static void
+logger_task_deliver (LOGGER_TASK_T *logger_task, uint32_t reason)
+{
+    logger_task->refs = 1 ;
+
     if (reason == SERVICE_CALLBACK_REASON_RUN) {
 
         LOGGER_CHANNEL_T * start ;
@@ -148,9 +437,8 @@ logger_task_callback (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
                         SVC_LOGGER_GET_SEVERITY(logger_task->type) <=
                                 (SVC_LOGGER_GET_SEVERITY(start->filter[i].type)) &&
                             (mask & start->filter[i].mask) &&
-                        start->fp
+                        (start->fp || start->record)
                     ) {
-                    const char* msg ;
 
                     if (!(logger_task->type & SVC_LOGGER_FLAGS_PROGRESS) ||
                                 (start->filter[i].type & SVC_LOGGER_FLAGS_PROGRESS)) {
@@ -166,9 +454,12 @@ logger_task_callback (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
                         }
 #endif
 
-                        msg = (const char*)&logger_task->message[offset] ;
+                        if (start->queue) {
+                            logger_queue_push (start->queue, logger_task, offset) ;
+                            break ;
+                        }
 
-                        start->fp (start, logger_task->type, logger_task->facility, msg) ;
+                        logger_deliver (start, logger_task, offset) ;
                             break ;
 
                     }
@@ -185,98 +476,357 @@ logger_task_callback (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
 
 
     }
-    os_sys_lock();
-    _logger_debug_sending-- ;
-    os_sys_unlock();
-    svc_tasks_complete (task) ;
-    qoraal_free(QORAAL_HeapAuxiliary, task) ;
+    logger_task_release (logger_task) ;
 }
 
+/**
+* @brief   SVC Task callback delivering the queued log messages.
+* @note    Takes one message at a time so a message of a higher severity
+*          class queued meanwhile is delivered next.
+*
+* @param[in] task
+* @param[in] parm
+* @param[in] reason
+*
+* @notapi
+*/
+static void
+logger_dispatch_callback (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
+{
+    LOGGER_TASK_T *logger_task ;
+    LOGGER_TASK_T *more ;
+
+    while ((logger_task = logger_dequeue ()) != 0) {
+        /* the parts of a split message take one queue entry together */
+        do {
+            more = logger_task->more ;
+            logger_task_deliver (logger_task, reason) ;
+            logger_task = more ;
+        } while (logger_task) ;
+        /* counted up under the lock with the high water mark */
+        os_sys_lock();
+        _logger_debug_sending-- ;
+        os_sys_unlock();
+    }
 
+    svc_tasks_complete (task) ;
+}
 
 /**
-* @brief   Allocate a logger task and format the log message.
+* @brief   Queues a log message in its severity class and wakes up the
+*          dispatch task.
+* @note    The message is freed if its class has no room left.
 *
-* @param[in] format_str    format string
-* @param[in] args           argument list
+* @param[in] task          message
 *
-* @return              LOGGER_TASK_T
+* @return              EOK or E_TIMEOUT
 *
 * @notapi
 */
-static LOGGER_TASK_T*
-logger_create_task (LOGGER_TYPE_T type, uint8_t facility, const char *format_str, va_list  args)
+static int32_t
+logger_enqueue (LOGGER_TASK_T * task)
 {
-    LOGGER_TASK_T* task;
+    uint32_t cls = logger_class (task->type) ;
+    LOGGER_CLASS_QUEUE_T * queue = &_logger_class_queue[cls] ;
+
+    os_sys_lock();
+    if (_logger_debug_sending >= _logger_class_limit[cls]) {
+        LOGGER_TASK_T * more ;
+        _logger_stats.dropped++ ;
+        os_sys_unlock();
+        do {
+            more = task->more ;
+            qoraal_free(QORAAL_HeapAuxiliary, task);
+            task = more ;
+        } while (task) ;
+        return E_TIMEOUT ;
+    }
+    task->next = 0 ;
+    if (queue->tail) {
+        queue->tail->next = task ;
+    } else {
+        queue->head = task ;
+    }
+    queue->tail = task ;
+    _logger_debug_sending++ ;
+    _logger_stats.enqueued++ ;
+    if ((uint32_t)_logger_debug_sending > _logger_stats.high_water) {
+        _logger_stats.high_water = _logger_debug_sending ;
+    }
+    os_sys_unlock();
+
+#if defined SERVICE_LOGGER_TASK && SERVICE_LOGGER_TASK
+    /* E_BUSY when the dispatch task is already queued, it takes this one too. */
+    svc_tasks_schedule (&_logger_dispatch_task, logger_dispatch_callback, 0, _logger_task_prio, 0) ;
+#else
+    logger_dispatch_callback (&_logger_dispatch_task, 0, SERVICE_CALLBACK_REASON_RUN) ;
+#endif
+
+    return EOK ;
+}
+
+
+
 #if !SVC_LOGGER_APPEND_CRLF
 #define EXTRA_CHARS 2
 #else
 #define EXTRA_CHARS 4
 #endif
 
-    uint32_t len = 0 ;
-    uint32_t message_size =  LOG_MESSAGE_SIZE ;
-    if (!message_size) {
-        va_list args_copy;
-        va_copy(args_copy, args);
-        int32_t strlen =  vsnprintf(0, 0, (char*)format_str, args_copy);
-        va_end(args_copy);
-        if (strlen < 0) return 0 ;
-        message_size = strlen + 32 + EXTRA_CHARS ;
+/**
+* @brief   Takes a free scratch buffer from the pool.
+*
+* @return              buffer of SVC_LOGGER_FORMAT_BUFFER_SIZE or 0 if all are in use.
+*
+* @notapi
+*/
+static char *
+logger_scratch_get (void)
+{
+    char * buffer = 0 ;
+    int i ;
 
+    os_sys_lock();
+    for (i=0; i<SVC_LOGGER_FORMAT_BUFFER_CNT; i++) {
+        if (!(_logger_scratch_used & (1 << i))) {
+            _logger_scratch_used |= (1 << i) ;
+            buffer = _logger_scratch[i] ;
+            break ;
+        }
     }
-    task = (LOGGER_TASK_T*)qoraal_malloc(QORAAL_HeapAuxiliary, sizeof(LOGGER_TASK_T) + message_size + EXTRA_CHARS);
-
-    if (!task) {
-        return 0;
+    if (!buffer) {
+        _logger_stats.scratch_busy++ ;
     }
-    memset(task, 0, sizeof(LOGGER_TASK_T) + message_size + EXTRA_CHARS);
-    task->id = _logger_id++ ;
-    task->type = type ;
-    task->facility = facility ;
+    os_sys_unlock();
+
+    return buffer ;
+}
+
+static void
+logger_scratch_put (char * buffer)
+{
+    int i = (buffer - _logger_scratch[0]) / SVC_LOGGER_FORMAT_BUFFER_SIZE ;
+
+    os_sys_lock();
+    _logger_scratch_used &= ~(1 << i) ;
+    os_sys_unlock();
+}
+
+/**
+* @brief   Formats the timestamp prefix and the log message in one pass.
+*
+* @param[out] buffer       SVC_LOGGER_FORMAT_BUFFER_SIZE characters
+* @param[in] type          logger type
+* @param[in] timestamp     os_sys_ns_timestamp() of the message
+* @param[in] format_str    format string
+* @param[in] args          argument list
+* @param[out] body         offset of the message following the prefix
+*
+* @return              length of the message excluding the terminator.
+*
+* @notapi
+*/
+static uint32_t
+logger_format (char * buffer, LOGGER_TYPE_T type, uint64_t timestamp, const char *format_str, va_list  args, uint32_t * body)
+{
+    const uint32_t size = SVC_LOGGER_FORMAT_BUFFER_SIZE ;
+    uint32_t len = 0 ;
+    int32_t res ;
 
 #if SVC_LOGGER_APPEND_TIMESTAMP
     if ( !(type & (SVC_LOGGER_FLAGS_NO_FORMATTING|SVC_LOGGER_FLAGS_NO_TIMESTAMP)) ) {
         uint32_t seconds ;
         uint32_t mseconds ;
-        mseconds = (unsigned int)os_sys_timestamp() ;
+        mseconds = (uint32_t)(timestamp / 1000000ULL) ;
         seconds = mseconds / 1000;
         mseconds %= 1000 ;
-        len += snprintf((char*)&(task->message[len]), 
-                message_size - EXTRA_CHARS,
+        len += snprintf(&buffer[len], size - EXTRA_CHARS,
                 "[%05u.%03u] ",
                 (unsigned int)(seconds % 100000),
                 (unsigned int)(mseconds % 1000));
 #ifdef SVC_LOGGER_MEMSTAT_HEAP
         uint32_t memalloc, memfree ;
         heap_stats (SVC_LOGGER_MEMSTAT_HEAP, &memalloc, &memfree) ;
-        len += snprintf((char*)&(task->message[len]), message_size, "[%.5u/%.5u] ",
+        len += snprintf(&buffer[len], size - len - EXTRA_CHARS, "[%.5u/%.5u] ",
                 (unsigned int)memalloc, (unsigned int)memfree);
 #endif
     }
+#else
+    (void)timestamp ;
 #endif
-    len += vsnprintf((char*)&task->message[len], message_size - len - EXTRA_CHARS, (char*)format_str, args);
+
+    *body = len ;
+    res = vsnprintf(&buffer[len], size - len - EXTRA_CHARS, (char*)format_str, args);
+    if (res < 0) {
+        res = 0 ;
+        buffer[len] = '\0' ;
+    } else if ((uint32_t)res >= size - len - EXTRA_CHARS) {
+        res = size - len - EXTRA_CHARS - 1 ;
+        OS_ATOMIC_INC (&_logger_stats.truncated) ;
+    }
+    len += res ;
+
     if (!(type & SVC_LOGGER_FLAGS_NO_FORMATTING)) {
-        if (len >= message_size - EXTRA_CHARS) len = message_size - EXTRA_CHARS -1 ;
-        if (task->message[len-1] == '\n') len-- ;
-        if (task->message[len-1] == '\r') len-- ;
+        if (len && (buffer[len-1] == '\n')) len-- ;
+        if (len && (buffer[len-1] == '\r')) len-- ;
 #if SVC_LOGGER_APPEND_CRLF
-        strcpy(&task->message[len], "\r\n") ;
+        strcpy(&buffer[len], "\r\n") ;
+        len += 2 ;
 #else
-        task->message[len] = '\0' ;
+        buffer[len] = '\0' ;
 #endif
 
     }
 
-    svc_tasks_init_task(&task->task);
+    return len ;
+}
 
-    return task ;
+/**
+* @brief   Folds a message identical to the previous one into a repeat count.
+* @note    The count is handed back for reporting when a different message
+*          arrives or, while the repeats continue, every
+*          SVC_LOGGER_DEDUP_WINDOW_MS.
+*
+* @param[in] type          logger type
+* @param[in] facility      facility
+* @param[in] hash          hash of the formatted message
+* @param[out] report       repeats of the previous message to report, if any
+*
+* @return              1 if the message was folded and should not be logged.
+*
+* @notapi
+*/
+static uint32_t
+logger_dedup (LOGGER_TYPE_T type, uint8_t facility, uint32_t hash, LOGGER_DEDUP_T * report)
+{
+    uint32_t now = os_sys_timestamp () ;
+    uint32_t folded = 0 ;
+
+    os_sys_lock();
+    *report = _logger_dedup ;
+    report->repeats = 0 ;
+    if ((hash == _logger_dedup.hash) && (type == _logger_dedup.type) &&
+            (facility == _logger_dedup.facility)) {
+        _logger_dedup.repeats++ ;
+        _logger_stats.deduplicated++ ;
+        if ((uint32_t)(now - _logger_dedup.start) >= SVC_LOGGER_DEDUP_WINDOW_MS) {
+            report->repeats = _logger_dedup.repeats ;
+            _logger_dedup.repeats = 0 ;
+            _logger_dedup.start = now ;
+        }
+        folded = 1 ;
+
+    } else {
+        report->repeats = _logger_dedup.repeats ;
+        _logger_dedup.hash = hash ;
+        _logger_dedup.type = type ;
+        _logger_dedup.facility = facility ;
+        _logger_dedup.repeats = 0 ;
+        _logger_dedup.start = now ;
+
+    }
+    os_sys_unlock();
+
+    return folded ;
+}
+
+/**
+* @brief   Allocate a logger task and format the log message.
+* @note    The message is formatted once into a pooled scratch buffer and
+*          copied to an exactly sized task. When every scratch buffer is in
+*          use it is formatted straight into a task of the maximum size.
+*
+* @param[out] ptask        the task, 0 if the message was folded into a repeat
+* @param[in] format_str    format string
+* @param[in] args          argument list
+* @param[in] fields        record fields encoded after the message, or 0
+* @param[in] count         number of fields
+* @param[out] report       repeats to report before this message, 0 to not deduplicate
+*
+* @return              EOK or E_NOMEM
+*
+* @notapi
+*/
+static int32_t
+logger_create_task (LOGGER_TASK_T ** ptask, LOGGER_TYPE_T type, uint8_t facility, const char *format_str, va_list  args,
+        const LOGREC_FIELD_T * fields, uint32_t count, LOGGER_DEDUP_T * report)
+{
+    LOGGER_TASK_T* task = 0 ;
+    uint64_t timestamp = os_sys_ns_timestamp () ;
+    char * scratch = logger_scratch_get () ;
+    uint32_t record = fields ? logrec_size (fields, count) : 0 ;
+    uint32_t body ;
+    uint32_t len ;
+
+    *ptask = 0 ;
+
+    if (scratch) {
+        len = logger_format (scratch, type, timestamp, format_str, args, &body) ;
+        if (report && SVC_LOGGER_DEDUP_WINDOW_MS &&
+                !(type & (SVC_LOGGER_FLAGS_NO_FORMATTING|SVC_LOGGER_FLAGS_PROGRESS))) {
+            uint32_t hash = 2166136261UL ;
+            uint32_t i ;
+            for (i=body; i<len; i++) {
+                hash = (hash ^ (uint8_t)scratch[i]) * 16777619UL ;
+            }
+            if (logger_dedup (type, facility, hash, report)) {
+                logger_scratch_put (scratch) ;
+                return EOK ;
+            }
+        }
+        task = (LOGGER_TASK_T*)qoraal_malloc(QORAAL_HeapAuxiliary, sizeof(LOGGER_TASK_T) + len + 1 + record);
+        if (task) {
+            memcpy (task->message, scratch, len + 1) ;
+        }
+        logger_scratch_put (scratch) ;
+
+    } else {
+        task = (LOGGER_TASK_T*)qoraal_malloc(QORAAL_HeapAuxiliary, sizeof(LOGGER_TASK_T) + SVC_LOGGER_FORMAT_BUFFER_SIZE + record);
+        if (task) {
+            len = logger_format (task->message, type, timestamp, format_str, args, &body) ;
+        }
+
+    }
+
+    if (!task) {
+        return E_NOMEM;
+    }
+
+    memset(task, 0, sizeof(LOGGER_TASK_T));
+    task->id = _logger_id++ ;
+    task->type = type ;
+    task->facility = facility ;
+    task->timestamp = timestamp ;
+    task->len = len ;
+    if (record) {
+        task->record = logrec_encode ((uint8_t*)&task->message[len + 1], record, fields, count) ;
+    }
+
+    OS_ATOMIC_INC (&_logger_stats.formatted) ;
+
+    *ptask = task ;
+
+    return EOK ;
+}
+
+static int32_t  svc_logger_vlogx (LOGGER_TYPE_T type, uint8_t facility, uint32_t dedup, const LOGREC_FIELD_T * fields, uint32_t count, const char *format_str, va_list    args) ;
+
+static void
+logger_report_repeats (const LOGGER_DEDUP_T * report, ...)
+{
+    va_list         args;
+    va_start(args, report);
+    svc_logger_vlogx (report->type, report->facility, 0, 0, 0, "last message repeated %u times", args) ;
+    va_end (args) ;
 }
 
 /**
  * @brief   Adds a message to the logger queue.
  *
  * @param[in] type          logger type, severity, facility and flags defined in svc_logger.h
+ * @param[in] dedup         fold the message into a repeat count if it is the same as the last one
+ * @param[in] fields        record fields, or 0
+ * @param[in] count         number of fields
  * @param[in] format_str    format string
  * @param[in] args          argument list
  *
@@ -285,23 +835,30 @@ logger_create_task (LOGGER_TYPE_T type, uint8_t facility, const char *format_str
  * @notapi
  */
 static int32_t
-svc_logger_vlogx (LOGGER_TYPE_T type, uint8_t facility, const char *format_str, va_list    args)
+svc_logger_vlogx (LOGGER_TYPE_T type, uint8_t facility, uint32_t dedup, const LOGREC_FIELD_T * fields, uint32_t count, const char *format_str, va_list    args)
 {
     LOGGER_TASK_T* task;
+    LOGGER_DEDUP_T report ;
     //static uint16_t id = 0 ;
 
-#if defined SERVICE_LOGGER_TASK && SERVICE_LOGGER_TASK
-    int32_t status = EOK;
-#endif
-
-    if (_logger_debug_sending >= SVC_LOGGER_MAX_QUEUE_SIZE) {
+    if (logger_full (type)) {
+        logger_dropped () ;
         return E_TIMEOUT ;
     }
 
-    task = logger_create_task (type, facility, format_str, args);
+    report.repeats = 0 ;
+    if (logger_create_task (&task, type, facility, format_str, args, fields, count,
+                dedup ? &report : 0) != EOK) {
+        logger_dropped () ;
+        return E_NOMEM;
+    }
+
+    if (report.repeats) {
+        logger_report_repeats (&report, (unsigned int)report.repeats) ;
+    }
 
     if (task == 0) {
-        return E_NOMEM;
+        return EOK ;
     }
 
 #if !defined CFG_COMMON_MEMLOG_DISABLE
@@ -309,29 +866,17 @@ svc_logger_vlogx (LOGGER_TYPE_T type, uint8_t facility, const char *format_str,
             (SVC_LOGGER_GET_SEVERITY(type) <= SVC_LOGGER_GET_SEVERITY(_logger_filter_mem.type)) &&
             (SVC_LOGGER_FACILITY_MASK(facility) & _logger_filter_mem.mask)
         ) {
-        mlog_log (facility, SVC_LOGGER_GET_SEVERITY(task->type), (char*)task->message) ;
+        mlog_record (facility, SVC_LOGGER_GET_SEVERITY(task->type), (char*)task->message,
+                (const uint8_t*)&task->message[task->len + 1], task->record) ;
     }
 #endif
 
-#if defined SERVICE_LOGGER_TASK && SERVICE_LOGGER_TASK
-    if (    (SVC_LOGGER_GET_SEVERITY(type) > SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) ||
-            (status = svc_tasks_schedule((SVC_TASKS_T*)task, logger_task_callback, 0, _logger_task_prio, 0) != EOK)
-        ) {
+    if (SVC_LOGGER_GET_SEVERITY(type) > SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) {
         qoraal_free(QORAAL_HeapAuxiliary, task);
+        return EOK ;
     }
-    else {
-        os_sys_lock();
-        _logger_debug_sending++;
-        os_sys_unlock();
-    }
-
-    return status ;
-#else
-    _logger_debug_sending++;
-    logger_task_callback ((SVC_TASKS_T*)task, 0, SERVICE_CALLBACK_REASON_RUN) ;
-    return EOK;
-#endif
 
+    return logger_enqueue (task) ;
 }
 
 /**
@@ -381,7 +926,7 @@ int32_t
 svc_logger_type_vlog (LOGGER_TYPE_T type, uint8_t facility, const char *format_str, va_list    args)
 {
     if (svc_logger_would_log(type, facility)) {
-        return svc_logger_vlogx (type, facility, format_str, args) ;
+        return svc_logger_vlogx (type, facility, 1, 0, 0, format_str, args) ;
 
     }
 
@@ -409,6 +954,57 @@ svc_logger_type_log (LOGGER_TYPE_T type, uint8_t facility, const char *format_st
     return res ;
 }
 
+/**
+ * @brief   Adds a structured message to the logger queue.
+ * @note    The fields are encoded once into a binary record stored after the
+ *          message, see logrec.h. Record channels and mlog keep the record
+ *          as is, text channels get it rendered as " key=value" pairs.
+ *
+ * @param[in] type          logger type, severity, facility and flags defined in svc_logger.h
+ * @param[in] facility      facility
+ * @param[in] fields        fields
+ * @param[in] count         number of fields
+ * @param[in] format_str    format string
+ * @param[in] args          argument list
+ *
+ * @return              Error.
+ *
+ * @svc
+ */
+int32_t
+svc_logger_type_vrecord (LOGGER_TYPE_T type, uint8_t facility, const LOGREC_FIELD_T * fields, uint32_t count, const char *format_str, va_list args)
+{
+    if (svc_logger_would_log(type, facility)) {
+        return svc_logger_vlogx (type, facility, 0, fields, count, format_str, args) ;
+
+    }
+
+    return EOK ;
+}
+
+/**
+ * @brief   Adds a structured message to the logger queue.
+ *
+ * @param[in] type          logger type, severity, facility and flags defined in svc_logger.h
+ * @param[in] facility      facility
+ * @param[in] fields        fields
+ * @param[in] count         number of fields
+ * @param[in] format_str    format string
+ *
+ * @return              Error.
+ *
+ * @svc
+ */
+int32_t
+svc_logger_type_record (LOGGER_TYPE_T type, uint8_t facility, const LOGREC_FIELD_T * fields, uint32_t count, const char *format_str, ...)
+{
+    va_list         args;
+    va_start(args, format_str);
+    int32_t res = svc_logger_type_vrecord (type, facility, fields, count, format_str, args) ;
+    va_end (args) ;
+    return res ;
+}
+
 /**
  * @brief   Adds a message to the logger queue with severity report.
  * @note    Intended to be used like printf
@@ -465,39 +1061,23 @@ int32_t
 svc_logger_put (const char *str, uint32_t len)
 {
     LOGGER_TASK_T* task;
-    int32_t status ;
 
     task = (LOGGER_TASK_T*)qoraal_malloc(QORAAL_HeapAuxiliary, sizeof(LOGGER_TASK_T) +len+1);
 
     if (!task) {
+        logger_dropped () ;
         return 0;
     }
     memset(task, 0, sizeof(LOGGER_TASK_T) +len+1);
     task->id = _logger_id++ ;
+    task->timestamp = os_sys_ns_timestamp () ;
     task->type = SVC_LOGGER_TYPE(SVC_LOGGER_SEVERITY_REPORT,
             SVC_LOGGER_FLAGS_NO_FORMATTING|SVC_LOGGER_FLAGS_NO_TIMESTAMP|SVC_LOGGER_FLAGS_PROGRESS) ;
 
     strncpy((char*)&task->message[0],  (char*)str, len);
     task->message[len] = '\0';
-    svc_tasks_init_task(&task->task);
-
-#if defined SERVICE_LOGGER_TASK && SERVICE_LOGGER_TASK
-    status = svc_tasks_schedule((SVC_TASKS_T*)task, logger_task_callback, 0, _logger_task_prio, 0) ;
-    if (status  != EOK) {
-        qoraal_free(QORAAL_HeapAuxiliary, task);
-    }
-    else {
-        os_sys_lock();
-        _logger_debug_sending++;
-        os_sys_unlock();
-    }
-    return status ;
-#else
-    _logger_debug_sending++;
-    logger_task_callback ((SVC_TASKS_T*)task, 0, SERVICE_CALLBACK_REASON_RUN) ;
-    return EOK;
-#endif
 
+    return logger_enqueue (task) ;
 }
 
 /**
@@ -549,6 +1129,7 @@ svc_logger_vlog_state (int inst, const char *format_str, va_list    args)
 
          //msg->type = NSHELL_NOTIFY_LOG_STATE ;
          task->id = (uint32_t)inst ;
+         task->timestamp = os_sys_ns_timestamp () ;
          mseconds = (unsigned int)os_sys_timestamp() ;
          seconds = mseconds / 1000;
          mseconds %= 1000 ;
@@ -573,26 +1154,13 @@ svc_logger_vlog_state (int inst, const char *format_str, va_list    args)
         }
 #endif
 
-#if defined SERVICE_LOGGER_TASK && SERVICE_LOGGER_TASK
-        if (SVC_LOGGER_SEVERITY_WARNING <= SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) {
-            svc_tasks_init_task ((SVC_TASKS_T*)task) ;
-            if (
-                    (SVC_LOGGER_SEVERITY_REPORT > SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) ||
-                    !linked_head (&_logger_channels) ||
-                    (svc_tasks_schedule ((SVC_TASKS_T*)task, logger_task_callback, 0, _logger_task_prio, 0) != EOK)
-                ) {
-                qoraal_free(QORAAL_HeapAuxiliary, task) ;
-
-            } else {
-                os_sys_lock();
-                _logger_debug_sending++;
-                os_sys_unlock();
+        if ((SVC_LOGGER_SEVERITY_REPORT <= SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) &&
+                linked_head (&_logger_channels)) {
+            logger_enqueue (task) ;
 
-            }
-#else
-            logger_state_task_callback ((SVC_TASKS_T*)task, (uint32_t)0, SERVICE_CALLBACK_REASON_RUN) ;
+        } else {
+            qoraal_free(QORAAL_HeapAuxiliary, task) ;
 
-#endif
         }
 
     }
@@ -602,82 +1170,168 @@ svc_logger_vlog_state (int inst, const char *format_str, va_list    args)
 
 
 
+/**
+ * @brief   Logs a hex dump of memory.
+ * @note    The dump is rendered line by line straight into logger tasks of
+ *          SVC_LOGGER_MEM_CHUNK_SIZE characters, with head in the first and
+ *          tail in the last. The chunks are chained and queued as one
+ *          message, so a dump of any size takes a single queue entry.
+ *
+ * @param[in] type          logger type, severity and flags defined in svc_logger.h
+ * @param[in] facility      facility
+ * @param[in] mem           memory to dump
+ * @param[in] size          bytes to dump
+ * @param[in] head          text preceding the dump or 0
+ * @param[in] tail          text following the dump or 0
+ *
+ * @return              Error.
+ *
+ * @svc
+ */
 int32_t
 svc_logger_type_mem (LOGGER_TYPE_T type, uint8_t facility, const char* mem, uint32_t size, const char * head, const char * tail)
 {
-    int32_t status = 0 ;
-    int len  ;
+    const int width = 16 ;
+    uint32_t head_len = head ? strlen (head) : 0 ;
+    uint32_t tail_len = tail ? strlen (tail) : 0 ;
+    uint32_t offset = 0 ;
+    uint32_t line ;
+    uint32_t len  ;
+    LOGGER_TASK_T* first = 0 ;
+    LOGGER_TASK_T** last = &first ;
+    LOGGER_TASK_T* task;
 
-    if (_logger_debug_sending >= SVC_LOGGER_MAX_QUEUE_SIZE) {
+    if (logger_full (type)) {
+        logger_dropped () ;
         return E_TIMEOUT ;
     }
 
-
-    if (
+    if (!(
             (SVC_LOGGER_SEVERITY_WARNING <= SVC_LOGGER_GET_SEVERITY(_logger_filter.type))
 #if !defined CFG_COMMON_MEMLOG_DISABLE
               || (mlog_started() && (SVC_LOGGER_SEVERITY_WARNING <= SVC_LOGGER_GET_SEVERITY(_logger_filter_mem.type)))
 #endif
-                ) {
-
-
-        LOGGER_TASK_T* task;
-
-        uint32_t message_size =  size * 6 + 96 ;
-
+                )) {
+        return EOK ;
+    }
 
-        task = (LOGGER_TASK_T*)qoraal_malloc(QORAAL_HeapAuxiliary, sizeof(LOGGER_TASK_T)+message_size);
+    if (head_len + tail_len + DBG_MEM_DUMP_LINE_LENGTH(width) >= SVC_LOGGER_MEM_CHUNK_SIZE) {
+        return E_PARM ;
+    }
 
+    do {
+        task = (LOGGER_TASK_T*)qoraal_malloc(QORAAL_HeapAuxiliary, sizeof(LOGGER_TASK_T) + SVC_LOGGER_MEM_CHUNK_SIZE);
         if (!task) {
+            while (first) {
+                task = first->more ;
+                qoraal_free(QORAAL_HeapAuxiliary, first);
+                first = task ;
+            }
+            logger_dropped () ;
             return E_NOMEM ;
         }
         memset(task, 0, sizeof(LOGGER_TASK_T));
         task->id = _logger_id++ ;
         task->type = type ;
         task->facility = facility ;
-        len = snprintf(task->message, message_size, "%s", head);
+        task->timestamp = os_sys_ns_timestamp () ;
+        *last = task ;
+        last = &task->more ;
+
+        len = 0 ;
+        task->message[0] = '\0' ;
+        if (!offset && head_len) {
+            memcpy (task->message, head, head_len + 1) ;
+            len = head_len ;
+        }
+        do {
+            if (len + DBG_MEM_DUMP_LINE_LENGTH(width) + tail_len >= SVC_LOGGER_MEM_CHUNK_SIZE) {
+                break ;
+            }
+            line = (size - offset) > (uint32_t)width ? (uint32_t)width : size - offset ;
+            len += dbg_format_mem_dump_render (&task->message[len], &mem[offset], line, offset, width) ;
+            offset += line ;
+
+        } while (offset < size) ;
+
+        if (offset < size) {
+            /* the channels end every message with a newline of their own */
+            len -= sizeof(MEMDBG_NEWLINE) - 1 ;
+            task->message[len] = '\0' ;
+
+        } else if (tail_len) {
+            memcpy (&task->message[len], tail, tail_len + 1) ;
 
-#if 1
-        dbg_format_mem_dump_width (&task->message[len], message_size-len, mem, size, 0, 16) ;
-#else
-        len += snprintf(&task->message[len], message_size-len, "0x%p: ", mem);
-        for (int i=0; i<size; i++) {
-            len += sprintf (&task->message[len], "%.2X ", (char)mem[i]&0xFF);
-            if (len >= message_size-4) break ;
         }
-        len += snprintf(&task->message[len], message_size, "%s", tail);
-#endif
 
 #if !defined CFG_COMMON_MEMLOG_DISABLE
-    if (mlog_started() && (SVC_LOGGER_GET_SEVERITY(type) <= SVC_LOGGER_GET_SEVERITY(_logger_filter_mem.type))) {
-        mlog_log (0, SVC_LOGGER_GET_SEVERITY(type), (char*)task->message) ;
-    }
+        if (mlog_started() && (SVC_LOGGER_GET_SEVERITY(type) <= SVC_LOGGER_GET_SEVERITY(_logger_filter_mem.type))) {
+            mlog_log (facility, SVC_LOGGER_GET_SEVERITY(type), (char*)task->message) ;
+        }
 #endif
 
-#if defined SERVICE_LOGGER_TASK && SERVICE_LOGGER_TASK
-    if (    (SVC_LOGGER_GET_SEVERITY(type) > SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) ||
-            (status = svc_tasks_schedule((SVC_TASKS_T*)task, logger_task_callback, 0, _logger_task_prio, 0) != EOK)
-        ) {
-        qoraal_free(QORAAL_HeapAuxiliary, task);
-    }
-    else {
-        os_sys_lock();
-        _logger_debug_sending++;
-        os_sys_unlock();
-    }
-    return status ;
-#else
-    _logger_debug_sending++;
-    logger_task_callback ((SVC_TASKS_T*)task, 0, SERVICE_CALLBACK_REASON_RUN) ;
-    return EOK;
-#endif
+    } while (offset < size) ;
 
+    if (SVC_LOGGER_GET_SEVERITY(type) > SVC_LOGGER_GET_SEVERITY(_logger_filter.type)) {
+        while (first) {
+            task = first->more ;
+            qoraal_free(QORAAL_HeapAuxiliary, first);
+            first = task ;
+        }
+        return EOK ;
     }
 
+    return logger_enqueue (first) ;
+}
+
 
-    return EOK ;
+static void
+logger_gate_merge (uint8_t * gate, LOGGGER_CHANNEL_FILTER_T filter)
+{
+    uint8_t severity = SVC_LOGGER_GET_SEVERITY(filter.type) ;
+    int i ;
+
+    if (!filter.mask) return ;
+
+    if (gate[0] < severity) gate[0] = severity ;
+    for (i=1; i<SVC_LOGGER_FACILITY_CNT; i++) {
+        if ((filter.mask & SVC_LOGGER_FACILITY_MASK(i)) && (gate[i] < severity)) {
+            gate[i] = severity ;
+        }
+    }
 }
 
+/**
+ * @brief       Rebuilds the per facility gate checked by SVC_LOGGER_ENABLED().
+ * @note        Called with _logger_mutex held.
+ *
+ * @notapi
+ */
+static void
+logger_gate_update (void)
+{
+    uint8_t * gate = (svc_logger_gate == _logger_gate_table[0]) ?
+            _logger_gate_table[1] : _logger_gate_table[0] ;
+    LOGGER_CHANNEL_T * start ;
+    int i ;
+
+    memset (gate, SVC_LOGGER_SEVERITY_NEVER, SVC_LOGGER_FACILITY_CNT) ;
+
+    for ( start = (LOGGER_CHANNEL_T*)linked_head (&_logger_channels) ;
+            (start!=NULL_LLO) ;
+            start = (LOGGER_CHANNEL_T*)linked_next ((plists_t)start, OFFSETOF(LOGGER_CHANNEL_T, next)) ) {
+        for (i=0; i<SVC_LOGGER_FILTER_CNT; i++) {
+            logger_gate_merge (gate, start->filter[i]) ;
+        }
+    }
+#if !defined CFG_COMMON_MEMLOG_DISABLE
+    if (mlog_started()) {
+        logger_gate_merge (gate, _logger_filter_mem) ;
+    }
+#endif
+
+    svc_logger_gate = gate ;
+}
 
 /**
  * @brief       Gets the lowest severity of all the registered log channels.
@@ -717,6 +1371,8 @@ severity_channel_available(void)
     _logger_filter.type = SVC_LOGGER_TYPE(severity, 0) ;
     _logger_filter.mask = mask ;
 
+    logger_gate_update () ;
+
 }
 
 /**
@@ -733,7 +1389,10 @@ void
 svc_logger_set_mem_filter (LOGGGER_CHANNEL_FILTER_T filter)
 {
 #if !defined CFG_COMMON_MEMLOG_DISABLE
+    os_mutex_lock (&_logger_mutex) ;
     _logger_filter_mem = filter ;
+    logger_gate_update () ;
+    os_mutex_unlock (&_logger_mutex) ;
 #endif
 }
 
@@ -749,6 +1408,22 @@ svc_logger_set_mem_filter (LOGGGER_CHANNEL_FILTER_T filter)
 void
 svc_logger_channel_add (LOGGER_CHANNEL_T * channel)
 {
+    channel->queue = 0 ;
+    memset (&channel->stats, 0, sizeof(channel->stats)) ;
+    if (channel->queue_size) {
+        LOGGER_CHANNEL_QUEUE_T * queue = (LOGGER_CHANNEL_QUEUE_T*)qoraal_malloc(QORAAL_HeapAuxiliary,
+                sizeof(LOGGER_CHANNEL_QUEUE_T) + channel->queue_size * sizeof(LOGGER_QUEUE_ENTRY_T)) ;
+        if (queue) {
+            memset (queue, 0, sizeof(LOGGER_CHANNEL_QUEUE_T)) ;
+            svc_tasks_init_task (&queue->task) ;
+            queue->channel = channel ;
+            queue->size = channel->queue_size ;
+            channel->queue = queue ;
+
+        }
+
+    }
+
     os_mutex_lock (&_logger_mutex) ;
     linked_add_tail (&_logger_channels, channel, OFFSETOF(LOGGER_CHANNEL_T, next)) ;
     severity_channel_available () ;
@@ -759,6 +1434,8 @@ svc_logger_channel_add (LOGGER_CHANNEL_T * channel)
 /**
  * @brief   Remove the registered log channel.
  * @note    To change a log channel severity, remove it, change the severity and add it again.
+ * @note    Messages still queued for an asynchronous channel are discarded.
+ *          It must not be removed from its own callback.
  *
  * @param[in] channel
  *
@@ -767,9 +1444,48 @@ svc_logger_channel_add (LOGGER_CHANNEL_T * channel)
 void
 svc_logger_channel_remove (LOGGER_CHANNEL_T * channel)
 {
+    LOGGER_CHANNEL_QUEUE_T * queue ;
+    LOGGER_QUEUE_ENTRY_T entry ;
+
     os_mutex_lock (&_logger_mutex) ;
     linked_remove (&_logger_channels, channel, OFFSETOF(LOGGER_CHANNEL_T, next)) ;
     severity_channel_available () ;
+    queue = channel->queue ;
+    channel->queue = 0 ;
+    os_mutex_unlock (&_logger_mutex) ;
+
+    if (queue) {
+        svc_tasks_cancel_wait (&queue->task, OS_TIME_INFINITE) ;
+        while (logger_queue_pop (queue, &entry)) {
+            logger_task_release (entry.task) ;
+        }
+        qoraal_free(QORAAL_HeapAuxiliary, queue) ;
+
+    }
+
+}
+
+/**
+ * @brief   Changes one filter of a registered log channel.
+ * @note    Unlike removing and adding the channel again no message is lost
+ *          and the queue of an asynchronous channel is kept.
+ *
+ * @param[in] channel
+ * @param[in] idx       filter index, less than SVC_LOGGER_FILTER_CNT
+ * @param[in] filter
+ *
+ * @svc
+ */
+void
+svc_logger_channel_set_filter (LOGGER_CHANNEL_T * channel, uint32_t idx, LOGGGER_CHANNEL_FILTER_T filter)
+{
+    if (idx >= SVC_LOGGER_FILTER_CNT) {
+        return ;
+    }
+
+    os_mutex_lock (&_logger_mutex) ;
+    channel->filter[idx] = filter ;
+    severity_channel_available () ;
     os_mutex_unlock (&_logger_mutex) ;
 
 }
@@ -812,7 +1528,7 @@ svc_logger_wait_all (uint32_t timeout)
 #if 0
     int32_t res = EOK ;
 #endif
-    while (_logger_debug_sending>0) {
+    while ((_logger_debug_sending>0) || (_logger_channel_pending>0)) {
         if (timeout <= SVC_TASK_MS2TICKS(10)) break ;
         os_thread_sleep (10) ;
         timeout -= SVC_TASK_MS2TICKS(10) ;
@@ -825,7 +1541,122 @@ svc_logger_wait_all (uint32_t timeout)
     }
 
 
-    return _logger_debug_sending ? EFAIL : EOK ;
+    return (_logger_debug_sending || _logger_channel_pending) ? EFAIL : EOK ;
+}
+
+/**
+ * @brief   Returns the logger statistics.
+ *
+ * @param[out] stats
+ *
+ * @svc
+ */
+void
+svc_logger_get_stats (SVC_LOGGER_STATS_T * stats)
+{
+    os_sys_lock();
+    *stats = _logger_stats ;
+    os_sys_unlock();
+}
+
+/**
+ * @brief   Calls cb with a copy of the statistics of every registered channel.
+ * @note    Called with the channel list locked, cb must not add or remove
+ *          channels.
+ *
+ * @param[in] cb
+ * @param[in] arg           passed to cb
+ *
+ * @svc
+ */
+void
+svc_logger_channel_stats (SVC_LOGGER_CHANNEL_STATS_CB cb, void* arg)
+{
+    SVC_LOGGER_CHANNEL_STATS_T stats ;
+    LOGGER_CHANNEL_T * start ;
+
+    os_mutex_lock (&_logger_mutex) ;
+    for ( start = (LOGGER_CHANNEL_T*)linked_head (&_logger_channels) ;
+            (start!=NULL_LLO) ;
+            start = (LOGGER_CHANNEL_T*)linked_next ((plists_t)start, OFFSETOF(LOGGER_CHANNEL_T, next)) ) {
+        os_sys_lock();
+        stats = start->stats ;
+        os_sys_unlock();
+        cb (arg, start, &stats) ;
+    }
+    os_mutex_unlock (&_logger_mutex) ;
+}
+
+/**
+ * @brief   Resets the logger and channel statistics. High water marks
+ *          restart from the current queue depth.
+ *
+ * @svc
+ */
+void
+svc_logger_reset_stats (void)
+{
+    LOGGER_CHANNEL_T * start ;
+
+    os_mutex_lock (&_logger_mutex) ;
+    os_sys_lock();
+    memset (&_logger_stats, 0, sizeof(_logger_stats)) ;
+    _logger_stats.high_water = _logger_debug_sending ;
+    os_sys_unlock();
+    for ( start = (LOGGER_CHANNEL_T*)linked_head (&_logger_channels) ;
+            (start!=NULL_LLO) ;
+            start = (LOGGER_CHANNEL_T*)linked_next ((plists_t)start, OFFSETOF(LOGGER_CHANNEL_T, next)) ) {
+        os_sys_lock();
+        memset (&start->stats, 0, sizeof(start->stats)) ;
+        start->stats.high_water = start->queue ? start->queue->count : 0 ;
+        os_sys_unlock();
+    }
+    os_mutex_unlock (&_logger_mutex) ;
+}
+
+/**
+ * @brief   Rate limits a call site, see DBG_MESSAGE_T_RATELIMIT.
+ * @note    Over the limit only the suppressed count is updated. When a new
+ *          interval starts the count is logged with the type and facility
+ *          of the call site.
+ *
+ * @param[in] ratelimit     call site state, SVC_LOGGER_RATELIMIT_DECL
+ * @param[in] type          logger type
+ * @param[in] facility      facility
+ *
+ * @return              1 if the message should be logged.
+ *
+ * @svc
+ */
+uint32_t
+svc_logger_ratelimit (SVC_LOGGER_RATELIMIT_T * ratelimit, LOGGER_TYPE_T type, uint8_t facility)
+{
+    uint32_t now = os_sys_timestamp () ;
+    uint32_t suppressed = 0 ;
+    uint32_t pass = 1 ;
+
+    os_sys_lock();
+    if (!ratelimit->count ||
+            ((uint32_t)(now - ratelimit->start) >= SVC_LOGGER_RATELIMIT_INTERVAL_MS)) {
+        suppressed = ratelimit->suppressed ;
+        ratelimit->start = now ;
+        ratelimit->count = 0 ;
+        ratelimit->suppressed = 0 ;
+    }
+    if (ratelimit->count < SVC_LOGGER_RATELIMIT_BURST) {
+        ratelimit->count++ ;
+    } else {
+        if (ratelimit->suppressed < 0xFFFF) ratelimit->suppressed++ ;
+        _logger_stats.ratelimited++ ;
+        pass = 0 ;
+    }
+    os_sys_unlock();
+
+    if (suppressed) {
+        svc_logger_type_log (type, facility, "%u messages suppressed", (unsigned int)suppressed) ;
+    }
+
+    return pass ;
 }
 
 const char *
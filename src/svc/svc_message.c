@@ -33,9 +33,17 @@ static SVC_MESSAGE_FILTER_T _message_filter = {0} ;
 static SVC_TASK_PRIO_T      _message_task_prio ;
 static uint32_t             _message_id = 0 ;
 static int32_t              _message_sending = 0 ;
+static uint32_t             _message_waiters = 0 ;
+static SVC_MESSAGE_STATS_T  _message_stats = {0} ;
+static SVC_MESSAGE_T *      _message_inflight = 0 ;
 
 static LISTS_LINKED_DECL    (_message_channels) ;
+static LISTS_LINKED_DECL    (_message_pending) ;
+static LISTS_LINKED_DECL    (_message_producers) ;
 static OS_MUTEX_DECL        (_message_mutex) ;
+static OS_MUTEX_DECL        (_message_queue_mutex) ;
+static OS_SEMAPHORE_DECL    (_message_progress_sem) ;
+static SVC_TASKS_DECL       (_message_dispatch_task) ;
 
 static void
 message_channel_available (void)
@@ -62,7 +70,7 @@ message_channel_matches (const SVC_MESSAGE_CHANNEL_T * channel, int32_t module)
     SVC_MESSAGE_MASK_T mask = SVC_MESSAGE_MODULE_MASK(module) ;
     int i ;
 
-    if (!channel || !channel->fp || !mask) {
+    if (!channel || !(channel->fp || channel->batch) || !mask) {
         return 0 ;
     }
 
@@ -75,44 +83,329 @@ message_channel_matches (const SVC_MESSAGE_CHANNEL_T * channel, int32_t module)
     return 0 ;
 }
 
+static void
+message_dispatch (SVC_MESSAGE_T * first)
+{
+    const SVC_MESSAGE_T * batch[SVC_MESSAGE_BATCH_SIZE] ;
+    SVC_MESSAGE_CHANNEL_T * start ;
+    SVC_MESSAGE_T * message ;
+    uint64_t now = os_sys_ns_timestamp () ;
+    uint32_t cnt ;
+
+    for ( start = (SVC_MESSAGE_CHANNEL_T*)linked_head (&_message_channels) ;
+            (start != NULL_LLO) ;
+            start = (SVC_MESSAGE_CHANNEL_T*)linked_next ((plists_t)start, OFFSETOF(SVC_MESSAGE_CHANNEL_T, next)) ) {
+        cnt = 0 ;
+        for (message = first ; message ; message = message->next) {
+            if (!message_channel_matches (start, message->module)) {
+                continue ;
+            }
+            start->stats.delivered++ ;
+            lathist_add (&start->stats.latency, (uint32_t)((now - message->timestamp) / 1000ULL)) ;
+            if (!start->batch) {
+                start->fp (start, message) ;
+                continue ;
+            }
+            batch[cnt++] = message ;
+            if (cnt == SVC_MESSAGE_BATCH_SIZE) {
+                start->batch (start, batch, cnt) ;
+                cnt = 0 ;
+            }
+        }
+        if (cnt) {
+            start->batch (start, batch, cnt) ;
+        }
+    }
+}
+
+static SVC_MESSAGE_T *
+message_pending_take (void)
+{
+    SVC_MESSAGE_T * first ;
+
+    os_mutex_lock (&_message_queue_mutex) ;
+    first = (SVC_MESSAGE_T*)linked_head (&_message_pending) ;
+    linked_init (&_message_pending) ;
+    _message_inflight = first ;
+    os_mutex_unlock (&_message_queue_mutex) ;
+
+    return first ;
+}
+
+static SVC_MESSAGE_PRODUCER_T *
+message_producer_find (int32_t module)
+{
+    SVC_MESSAGE_PRODUCER_T * start ;
+
+    for ( start = (SVC_MESSAGE_PRODUCER_T*)linked_head (&_message_producers) ;
+            (start != NULL_LLO) ;
+            start = (SVC_MESSAGE_PRODUCER_T*)linked_next ((plists_t)start, OFFSETOF(SVC_MESSAGE_PRODUCER_T, next)) ) {
+        if (start->module == module) {
+            break ;
+        }
+    }
+
+    return start ;
+}
+
+/**
+ * @brief       Accounts for a message leaving the queue. Must be called
+ *              with _message_queue_mutex held.
+ * @notapi
+ */
+static void
+message_unqueue (SVC_MESSAGE_T * message, uint32_t dropped)
+{
+    SVC_MESSAGE_PRODUCER_T * producer = message_producer_find (message->module) ;
+
+    if (producer) {
+        if (producer->stats.queued) producer->stats.queued-- ;
+        if (dropped) producer->stats.dropped++ ;
+    }
+    if (dropped) _message_stats.dropped++ ;
+    _message_sending-- ;
+}
+
+/**
+ * @brief       Wakes everybody waiting in message_enqueue() or
+ *              message_wait_idle() to re-evaluate. Must be called with
+ *              _message_queue_mutex held.
+ * @notapi
+ */
+static void
+message_progress_signal (void)
+{
+    while (_message_waiters) {
+        _message_waiters-- ;
+        os_sem_signal (&_message_progress_sem) ;
+    }
+}
+
+static void
+message_release (SVC_MESSAGE_T * first, uint32_t delivered)
+{
+    SVC_MESSAGE_T * message ;
+
+    os_mutex_lock (&_message_queue_mutex) ;
+    for (message = first ; message ; message = message->next) {
+        message_unqueue (message, 0) ;
+        if (delivered) _message_stats.delivered++ ;
+    }
+    _message_inflight = 0 ;
+    message_progress_signal () ;
+    os_mutex_unlock (&_message_queue_mutex) ;
+
+    while (first) {
+        message = first->next ;
+        qoraal_free (QORAAL_HeapAuxiliary, first) ;
+        first = message ;
+    }
+}
+
+/**
+ * @brief       Drains everything posted so far in a single pass. Posts
+ *              arriving while the channels are being called are picked up
+ *              by the next iteration without another trip through the
+ *              task scheduler.
+ * @notapi
+ */
 static void
 message_task_callback (SVC_TASKS_T * task, uintptr_t parm, uint32_t reason)
 {
-    SVC_MESSAGE_T * message = (SVC_MESSAGE_T*) task ;
+    SVC_MESSAGE_T * first ;
 
     (void)parm ;
 
-    if (reason == SERVICE_CALLBACK_REASON_RUN) {
-        SVC_MESSAGE_CHANNEL_T * start ;
+    os_mutex_lock (&_message_mutex) ;
+    while ((first = message_pending_take ()) != 0) {
+        if (reason == SERVICE_CALLBACK_REASON_RUN) {
+            message_dispatch (first) ;
+        }
+        message_release (first, reason == SERVICE_CALLBACK_REASON_RUN) ;
+    }
+    os_mutex_unlock (&_message_mutex) ;
 
-        os_mutex_lock (&_message_mutex) ;
-        for ( start = (SVC_MESSAGE_CHANNEL_T*)linked_head (&_message_channels) ;
-                (start != NULL_LLO) ;
-                start = (SVC_MESSAGE_CHANNEL_T*)linked_next ((plists_t)start, OFFSETOF(SVC_MESSAGE_CHANNEL_T, next)) ) {
-            if (message_channel_matches (start, message->module)) {
-                start->fp (start, message) ;
+    svc_tasks_complete (task) ;
+}
+
+/**
+ * @brief       Finds a pending message of the same module to make room for
+ *              message. Messages already taken by the dispatcher cannot be
+ *              shed. Must be called with _message_queue_mutex held.
+ * @notapi
+ */
+static SVC_MESSAGE_T *
+message_pending_victim (const SVC_MESSAGE_T * message, SVC_MESSAGE_POLICY_T policy)
+{
+    SVC_MESSAGE_T * victim = 0 ;
+    SVC_MESSAGE_T * start ;
+
+    for ( start = (SVC_MESSAGE_T*)linked_head (&_message_pending) ;
+            (start != NULL_LLO) ;
+            start = start->next ) {
+        if (start->module != message->module) {
+            continue ;
+        }
+        if (policy == SVC_MESSAGE_POLICY_DROP_OLDEST) {
+            return start ;
+        }
+        if ((start->prio < message->prio) &&
+                (!victim || (start->prio < victim->prio))) {
+            victim = start ;
+        }
+    }
+
+    return victim ;
+}
+
+/**
+ * @brief       Applies the producer limit and policy and appends message
+ *              to the pending list. Called with _message_queue_mutex held,
+ *              which is released while blocking.
+ * @notapi
+ */
+static int32_t
+message_enqueue (SVC_MESSAGE_T * message)
+{
+    SVC_MESSAGE_PRODUCER_T * producer = message_producer_find (message->module) ;
+    SVC_MESSAGE_POLICY_T policy = SVC_MESSAGE_POLICY_DROP_NEWEST ;
+    SVC_MESSAGE_T * victim ;
+    uint32_t start = os_sys_ticks () ;
+    uint32_t timeout = 0 ;
+    uint32_t elapsed ;
+
+    _message_stats.posted++ ;
+    if (producer) {
+        producer->stats.posted++ ;
+        policy = producer->policy ;
+        timeout = OS_MS2TICKS(producer->timeout) ;
+    }
+
+    while ((_message_sending >= SVC_MESSAGE_MAX_QUEUE_SIZE) ||
+            (producer && producer->limit && (producer->stats.queued >= producer->limit))) {
+
+        if (policy == SVC_MESSAGE_POLICY_BLOCK) {
+            elapsed = os_sys_ticks () - start ;
+            if (elapsed < timeout) {
+                _message_waiters++ ;
+                os_mutex_unlock (&_message_queue_mutex) ;
+                svc_tasks_schedule (&_message_dispatch_task, message_task_callback, 0, _message_task_prio, 0) ;
+                os_sem_wait_timeout (&_message_progress_sem, timeout - elapsed) ;
+                os_mutex_lock (&_message_queue_mutex) ;
+                producer = message_producer_find (message->module) ;
+                continue ;
+            }
+
+        } else if (policy != SVC_MESSAGE_POLICY_DROP_NEWEST) {
+            victim = message_pending_victim (message, policy) ;
+            if (victim) {
+                linked_remove (&_message_pending, victim, OFFSETOF(SVC_MESSAGE_T, next)) ;
+                message_unqueue (victim, 1) ;
+                message_progress_signal () ;
+                qoraal_free (QORAAL_HeapAuxiliary, victim) ;
+                continue ;
             }
+
         }
-        os_mutex_unlock (&_message_mutex) ;
+
+        if (producer) producer->stats.dropped++ ;
+        _message_stats.dropped++ ;
+        qoraal_free (QORAAL_HeapAuxiliary, message) ;
+        return E_TIMEOUT ;
+
     }
 
-    os_sys_lock() ;
-    _message_sending-- ;
-    os_sys_unlock() ;
+    message->next = 0 ;
+    linked_add_tail (&_message_pending, message, OFFSETOF(SVC_MESSAGE_T, next)) ;
+    _message_sending++ ;
+    if ((uint32_t)_message_sending > _message_stats.high_water) {
+        _message_stats.high_water = _message_sending ;
+    }
+    if (producer) {
+        producer->stats.queued++ ;
+        if (producer->stats.queued > producer->stats.high_water) {
+            producer->stats.high_water = producer->stats.queued ;
+        }
+    }
 
-    svc_tasks_complete (task) ;
-    qoraal_free (QORAAL_HeapAuxiliary, message) ;
+    return EOK ;
+}
+
+/**
+ * @brief       Returns 1 while any queued or in-flight message would still
+ *              be delivered to channel, or any at all if channel is NULL.
+ *              Must be called with _message_queue_mutex held.
+ * @notapi
+ */
+static uint32_t
+message_busy (const SVC_MESSAGE_CHANNEL_T * channel)
+{
+    SVC_MESSAGE_T * start ;
+
+    if (!channel) {
+        return _message_sending > 0 ;
+    }
+
+    for (start = _message_inflight ; start ; start = start->next) {
+        if (message_channel_matches (channel, start->module)) {
+            return 1 ;
+        }
+    }
+    for ( start = (SVC_MESSAGE_T*)linked_head (&_message_pending) ;
+            (start != NULL_LLO) ;
+            start = start->next ) {
+        if (message_channel_matches (channel, start->module)) {
+            return 1 ;
+        }
+    }
+
+    return 0 ;
+}
+
+static int32_t
+message_wait_idle (const SVC_MESSAGE_CHANNEL_T * channel, uint32_t timeout)
+{
+    uint32_t start = os_sys_ticks () ;
+    uint32_t elapsed ;
+    int32_t res = EOK ;
+
+    os_mutex_lock (&_message_queue_mutex) ;
+    while (message_busy (channel)) {
+        elapsed = os_sys_ticks () - start ;
+        if ((timeout != OS_TIME_INFINITE) && (elapsed >= timeout)) {
+            res = E_TIMEOUT ;
+            break ;
+        }
+        _message_waiters++ ;
+        os_mutex_unlock (&_message_queue_mutex) ;
+        if (timeout == OS_TIME_INFINITE) {
+            os_sem_wait (&_message_progress_sem) ;
+        } else {
+            os_sem_wait_timeout (&_message_progress_sem, timeout - elapsed) ;
+        }
+        os_mutex_lock (&_message_queue_mutex) ;
+    }
+    os_mutex_unlock (&_message_queue_mutex) ;
+
+    return res ;
 }
 
 int32_t
 svc_message_init (SVC_TASK_PRIO_T prio)
 {
     os_mutex_init (&_message_mutex) ;
+    os_mutex_init (&_message_queue_mutex) ;
+    os_sem_init (&_message_progress_sem, 0) ;
     linked_init (&_message_channels) ;
+    linked_init (&_message_pending) ;
+    linked_init (&_message_producers) ;
+    svc_tasks_init_task (&_message_dispatch_task) ;
     _message_filter.mask = 0 ;
     _message_task_prio = prio ;
     _message_id = 0 ;
     _message_sending = 0 ;
+    _message_waiters = 0 ;
+    memset (&_message_stats, 0, sizeof(_message_stats)) ;
 
     return EOK ;
 }
@@ -135,7 +428,6 @@ SVC_MESSAGE_T *
 svc_message_create (uint32_t size, uint32_t type, int32_t module)
 {
     SVC_MESSAGE_T * message ;
-    uint32_t now = qoraal_current_time() ;
 
     message = (SVC_MESSAGE_T*)qoraal_malloc (QORAAL_HeapAuxiliary, sizeof(SVC_MESSAGE_T) + size) ;
     if (!message) {
@@ -143,14 +435,12 @@ svc_message_create (uint32_t size, uint32_t type, int32_t module)
     }
 
     memset (message, 0, sizeof(SVC_MESSAGE_T) + size) ;
-    svc_tasks_init_task (&message->task) ;
 
     message->id = _message_id++ ;
     message->module = module ;
     message->type = type ;
     message->size = size ;
-    message->timestamp_ms = os_sys_timestamp() ;
-    rtc_localtime (now, &message->date, &message->time) ;
+    message->timestamp = os_sys_ns_timestamp () ;
 
     return message ;
 }
@@ -158,38 +448,171 @@ svc_message_create (uint32_t size, uint32_t type, int32_t module)
 int32_t
 svc_message_post (SVC_MESSAGE_T * message)
 {
-    int32_t status ;
-
     if (!message) {
         return E_PARM ;
     }
 
-    if (!svc_message_would_post (message->module)) {
-        qoraal_free (QORAAL_HeapAuxiliary, message) ;
-        return EOK ;
+    return svc_message_post_batch (&message, 1) ;
+}
+
+/**
+ * @brief       Posts an array of messages with a single dispatcher wakeup.
+ *              Messages for modules nobody listens to are released. Each
+ *              remaining message is queued according to the limit and
+ *              policy of its producer, see svc_message_producer_add().
+ *              Ownership of every message passes to this call.
+ *
+ * @param[in] messages  array of messages from svc_message_create()
+ * @param[in] count     number of entries in messages
+ *
+ * @return              EOK, E_PARM or E_TIMEOUT if any message was dropped
+ *
+ * @svc
+ */
+int32_t
+svc_message_post_batch (SVC_MESSAGE_T ** messages, uint32_t count)
+{
+    int32_t status = EOK ;
+    int32_t res ;
+    uint32_t queued = 0 ;
+    uint32_t i ;
+
+    if (!messages) {
+        return E_PARM ;
     }
 
-    if (_message_sending >= SVC_MESSAGE_MAX_QUEUE_SIZE) {
-        qoraal_free (QORAAL_HeapAuxiliary, message) ;
-        return E_TIMEOUT ;
+    os_mutex_lock (&_message_queue_mutex) ;
+    for (i = 0 ; i < count ; i++) {
+        if (!messages[i]) {
+            status = E_PARM ;
+            continue ;
+        }
+        if (!svc_message_would_post (messages[i]->module)) {
+            qoraal_free (QORAAL_HeapAuxiliary, messages[i]) ;
+            continue ;
+        }
+        res = message_enqueue (messages[i]) ;
+        if (res == EOK) {
+            queued++ ;
+        } else if (status == EOK) {
+            status = res ;
+        }
     }
+    os_mutex_unlock (&_message_queue_mutex) ;
 
-    status = svc_tasks_schedule (&message->task, message_task_callback, 0, _message_task_prio, 0) ;
-    if (status != EOK) {
-        qoraal_free (QORAAL_HeapAuxiliary, message) ;
-        return status ;
+    if (queued) {
+        /* E_BUSY only means the dispatcher is already queued and will pick
+           this batch up. */
+        svc_tasks_schedule (&_message_dispatch_task, message_task_callback, 0, _message_task_prio, 0) ;
     }
 
-    os_sys_lock() ;
-    _message_sending++ ;
-    os_sys_unlock() ;
+    return status ;
+}
 
-    return EOK ;
+/**
+ * @brief       Registers a queue limit and overflow policy for the
+ *              messages of producer->module. Statistics are reset.
+ *
+ * @note        A SVC_MESSAGE_POLICY_BLOCK producer must not post from a
+ *              channel callback, the dispatcher cannot make room for it.
+ *
+ * @param[in] producer  caller owned, must stay valid until removed
+ *
+ * @svc
+ */
+void
+svc_message_producer_add (SVC_MESSAGE_PRODUCER_T * producer)
+{
+    memset (&producer->stats, 0, sizeof(producer->stats)) ;
+    os_mutex_lock (&_message_queue_mutex) ;
+    linked_add_tail (&_message_producers, producer, OFFSETOF(SVC_MESSAGE_PRODUCER_T, next)) ;
+    os_mutex_unlock (&_message_queue_mutex) ;
+}
+
+void
+svc_message_producer_remove (SVC_MESSAGE_PRODUCER_T * producer)
+{
+    os_mutex_lock (&_message_queue_mutex) ;
+    linked_remove (&_message_producers, producer, OFFSETOF(SVC_MESSAGE_PRODUCER_T, next)) ;
+    message_progress_signal () ;
+    os_mutex_unlock (&_message_queue_mutex) ;
+}
+
+/**
+ * @brief       Totals across all modules. Per module figures are kept in
+ *              the registered SVC_MESSAGE_PRODUCER_T.
+ *
+ * @param[out] stats
+ *
+ * @svc
+ */
+void
+svc_message_get_stats (SVC_MESSAGE_STATS_T * stats)
+{
+    os_mutex_lock (&_message_queue_mutex) ;
+    *stats = _message_stats ;
+    stats->queued = _message_sending ;
+    os_mutex_unlock (&_message_queue_mutex) ;
+}
+
+void
+svc_message_reset_stats (void)
+{
+    SVC_MESSAGE_PRODUCER_T * start ;
+    SVC_MESSAGE_CHANNEL_T * channel ;
+
+    os_mutex_lock (&_message_mutex) ;
+    for ( channel = (SVC_MESSAGE_CHANNEL_T*)linked_head (&_message_channels) ;
+            (channel != NULL_LLO) ;
+            channel = (SVC_MESSAGE_CHANNEL_T*)linked_next ((plists_t)channel, OFFSETOF(SVC_MESSAGE_CHANNEL_T, next)) ) {
+        memset (&channel->stats, 0, sizeof(channel->stats)) ;
+    }
+    os_mutex_lock (&_message_queue_mutex) ;
+    _message_stats.posted = 0 ;
+    _message_stats.dropped = 0 ;
+    _message_stats.delivered = 0 ;
+    _message_stats.high_water = _message_sending ;
+    for ( start = (SVC_MESSAGE_PRODUCER_T*)linked_head (&_message_producers) ;
+            (start != NULL_LLO) ;
+            start = (SVC_MESSAGE_PRODUCER_T*)linked_next ((plists_t)start, OFFSETOF(SVC_MESSAGE_PRODUCER_T, next)) ) {
+        start->stats.posted = 0 ;
+        start->stats.dropped = 0 ;
+        start->stats.high_water = start->stats.queued ;
+    }
+    os_mutex_unlock (&_message_queue_mutex) ;
+    os_mutex_unlock (&_message_mutex) ;
+}
+
+/**
+ * @brief       Calls cb with a copy of the statistics of every registered
+ *              channel. Channels are locked against dispatch meanwhile, cb
+ *              must not add or remove channels.
+ *
+ * @param[in] cb
+ * @param[in] arg       passed to cb
+ *
+ * @svc
+ */
+void
+svc_message_channel_stats (SVC_MESSAGE_CHANNEL_STATS_CB cb, void * arg)
+{
+    SVC_MESSAGE_CHANNEL_STATS_T stats ;
+    SVC_MESSAGE_CHANNEL_T * start ;
+
+    os_mutex_lock (&_message_mutex) ;
+    for ( start = (SVC_MESSAGE_CHANNEL_T*)linked_head (&_message_channels) ;
+            (start != NULL_LLO) ;
+            start = (SVC_MESSAGE_CHANNEL_T*)linked_next ((plists_t)start, OFFSETOF(SVC_MESSAGE_CHANNEL_T, next)) ) {
+        stats = start->stats ;
+        cb (arg, start, &stats) ;
+    }
+    os_mutex_unlock (&_message_mutex) ;
 }
 
 void
 svc_message_channel_add (SVC_MESSAGE_CHANNEL_T * channel)
 {
+    memset (&channel->stats, 0, sizeof(channel->stats)) ;
     os_mutex_lock (&_message_mutex) ;
     linked_add_tail (&_message_channels, channel, OFFSETOF(SVC_MESSAGE_CHANNEL_T, next)) ;
     message_channel_available () ;
@@ -219,19 +642,42 @@ svc_message_wait (uint32_t timeout)
     return res ;
 }
 
+/**
+ * @brief       Waits until every message posted so far has been dispatched.
+ *              Returns as soon as the dispatcher releases the last one.
+ *
+ * @param[in] timeout   ticks
+ *
+ * @return              EOK or EFAIL if messages are still queued
+ *
+ * @svc
+ */
 int32_t
 svc_message_wait_all (uint32_t timeout)
 {
-    while (_message_sending > 0) {
-        if (timeout <= SVC_TASK_MS2TICKS(10)) {
-            break ;
-        }
+    return message_wait_idle (0, timeout) == EOK ? EOK : EFAIL ;
+}
 
-        os_thread_sleep (10) ;
-        timeout -= SVC_TASK_MS2TICKS(10) ;
+/**
+ * @brief       Waits until no queued or in-flight message matches the
+ *              filters of channel. Messages for other channels are not
+ *              waited for.
+ *
+ * @param[in] channel
+ * @param[in] timeout   ticks
+ *
+ * @return              EOK or E_TIMEOUT
+ *
+ * @svc
+ */
+int32_t
+svc_message_channel_flush (SVC_MESSAGE_CHANNEL_T * channel, uint32_t timeout)
+{
+    if (!channel) {
+        return E_PARM ;
     }
 
-    return _message_sending ? EFAIL : EOK ;
+    return message_wait_idle (channel, timeout) ;
 }
 
 SVC_MESSAGE_FILTER_T
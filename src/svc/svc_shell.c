@@ -32,6 +32,7 @@
 #include "qoraal/svc/svc_shell.h"
 #include "qoraal/svc/svc_wdt.h"
 #include "qoraal/common/strsub.h"
+#include "qoraal/common/memdbg.h"
 
 #if 1 // !defined CFG_NBOOT
 SVC_SHELL_CMD_DECL( "help", qshell_help, "[filter]");
@@ -390,30 +391,19 @@ int32_t svc_shell_write_hex(SVC_SHELL_IF_T * pif, uint32_t out,
         const uint8_t * buffer, uint32_t len)
 {
     int32_t res = len ;
-    uint32_t offset = 0;
-    uint32_t i;
-    uint32_t hex_len = sizeof(_qshell_buffer) - 1;  // Reserve space for null terminator
-    char *buf_ptr = _qshell_buffer;
+    uint32_t chunk = (sizeof(_qshell_buffer) - 1) / 2 ;  // Reserve space for null terminator
 
     while (len > 0) {
-        // Reset the buffer pointer and offset within each chunk
-        buf_ptr = _qshell_buffer;
-        offset = 0;
-
-        // Convert data from buffer to hex, chunk by chunk
-        for (i = 0; i < len && offset < hex_len; ++i) {
-            offset += snprintf(buf_ptr + offset, hex_len - offset, "%02x", buffer[i]);
-            if (offset >= hex_len) {
-                break;
-            }
+        if (chunk > len) {
+            chunk = len ;
         }
 
-        // Write the hex data to the output function
+        // Convert the chunk to hex and write it to the output function
+        dbg_format_hex (_qshell_buffer, (const char*)buffer, chunk, 1) ;
         pif->out(pif->ctx, out, _qshell_buffer);
 
-        // Update buffer pointer and remaining length
-        buffer += i;
-        len -= i;
+        buffer += chunk;
+        len -= chunk;
     }
 
     return res ;
@@ -31,11 +31,34 @@
 
 
 static uint32_t            _svc_threads_list_count = 0 ;
-static LISTS_LINKED_DECL   (_svc_threads_list) ;
+static SVC_THREADS_T *     _svc_threads_list_head = 0 ;
+static SVC_THREADS_T *     _svc_threads_list_tail = 0 ;
 static LISTS_LINKED_DECL   (_svc_threads_complete) ;
 static OS_MUTEX_DECL       (_svc_threads_mutex) ;
+/* os_thread_tls_set() stores 32 bits, a pointer may need more than one slot. */
+#define SVC_THREADS_TLS_SLOTS   ((sizeof (uintptr_t) + sizeof (uint32_t) - 1) / sizeof (uint32_t))
+static int32_t             _svc_threads_tls[SVC_THREADS_TLS_SLOTS] ;
+static bool                _svc_threads_tls_valid = false ;
 
-static void		svc_threads_terminate (void) ;
+#if SVC_THREADS_POOL_SIZE
+/*
+ * A pooled OS thread. It runs job and, if there is room in the pool, parks
+ * on sem until svc_threads_create() hands it the next one.
+ */
+typedef struct SVC_THREADS_WORKER_S {
+    struct SVC_THREADS_WORKER_S *   next ;
+    p_thread_t                      thread ;
+    p_sem_t                         sem ;
+    SVC_THREADS_T *                 job ;
+    size_t                          stack_size ;
+    uint32_t                        prio ;
+} SVC_THREADS_WORKER_T ;
+
+static uint32_t            _svc_threads_pool_count = 0 ;
+static LISTS_LINKED_DECL   (_svc_threads_pool) ;
+#else
+static void		svc_threads_terminate (SVC_THREADS_T* svc_thread) ;
+#endif
 
 #if !defined CFG_SVC_THREADS_DISABLE_IDLE
 static OS_SEMAPHORE_DECL (_svc_threads_sem) ;
@@ -50,6 +73,88 @@ static void svc_threads_idle( void * arg)
 }
 #endif
 
+/*
+ * Running threads are kept on a doubly linked list so a thread can take
+ * itself off it without a search. Called with the mutex locked.
+ */
+static void
+svc_threads_list_add (SVC_THREADS_T* thread)
+{
+    thread->next = 0 ;
+    thread->prev = _svc_threads_list_tail ;
+    if (_svc_threads_list_tail) {
+        _svc_threads_list_tail->next = thread ;
+    } else {
+        _svc_threads_list_head = thread ;
+    }
+    _svc_threads_list_tail = thread ;
+    _svc_threads_list_count++ ;
+}
+
+static void
+svc_threads_list_remove (SVC_THREADS_T* thread)
+{
+    if (thread->prev) {
+        thread->prev->next = thread->next ;
+    } else {
+        _svc_threads_list_head = thread->next ;
+    }
+    if (thread->next) {
+        thread->next->prev = thread->prev ;
+    } else {
+        _svc_threads_list_tail = thread->prev ;
+    }
+    thread->next = 0 ;
+    thread->prev = 0 ;
+    _svc_threads_list_count-- ;
+}
+
+/**
+ * @brief   Makes svc_thread what svc_threads_current() returns for the
+ *          calling thread, 0 to clear it.
+ * @note    The pointer is split over SVC_THREADS_TLS_SLOTS slots. Without
+ *          them svc_threads_current() searches the list.
+ *
+ * @notapi
+ */
+static void
+svc_threads_set_current (SVC_THREADS_T* svc_thread)
+{
+    uintptr_t value = (uintptr_t)svc_thread ;
+    uint32_t i ;
+
+    if (!_svc_threads_tls_valid) {
+        return ;
+    }
+    for (i = 0 ; i < SVC_THREADS_TLS_SLOTS ; i++) {
+        os_thread_tls_set (_svc_threads_tls[i], (uint32_t)value) ;
+        value = (uintptr_t)((uint64_t)value >> 32) ;
+    }
+}
+
+/**
+ * @brief   Moves a thread that returned from its function to the complete
+ *          list for cleanup. Called by the thread itself with the mutex
+ *          locked.
+ *
+ * @notapi
+ */
+static void
+svc_threads_retire (SVC_THREADS_T* svc_thread)
+{
+    DBG_MESSAGE_SVC_THREADS (DBG_MESSAGE_SEVERITY_INFO,
+        "SVC   : : svc_threads_terminate (obj 0x%x, thd 0x%x)",
+        svc_thread, svc_thread->thread) ;
+
+    svc_threads_set_current (0) ;
+    svc_threads_list_remove (svc_thread) ;
+    linked_add_head (&_svc_threads_complete, svc_thread, OFFSETOF(SVC_THREADS_T, next)) ;
+
+#if !defined CFG_SVC_THREADS_DISABLE_IDLE
+    os_sem_signal (&_svc_threads_sem) ;
+#endif
+}
+
 /**
  * @brief   svc_threads_init
  * @return              Error.
@@ -58,12 +163,28 @@ static void svc_threads_idle( void * arg)
 int32_t
 svc_threads_init (void)
 {
-    linked_init (&_svc_threads_list) ;
+    _svc_threads_list_head = 0 ;
+    _svc_threads_list_tail = 0 ;
     linked_init (&_svc_threads_complete) ;
+#if SVC_THREADS_POOL_SIZE
+    linked_init (&_svc_threads_pool) ;
+#endif
     os_mutex_init (&_svc_threads_mutex) ;
 #if !defined CFG_SVC_THREADS_DISABLE_IDLE
     os_sem_init (&_svc_threads_sem, 0) ;
 #endif
+    if (!_svc_threads_tls_valid) {
+        uint32_t i ;
+        for (i = 0 ; i < SVC_THREADS_TLS_SLOTS ; i++) {
+            if (os_thread_tls_alloc (&_svc_threads_tls[i]) != EOK) {
+                while (i--) {
+                    os_thread_tls_free (_svc_threads_tls[i]) ;
+                }
+                break ;
+            }
+        }
+        _svc_threads_tls_valid = (i == SVC_THREADS_TLS_SLOTS) ;
+    }
 
     return EOK ;
 }
@@ -89,13 +210,143 @@ svc_threads_start (void)
 }
 
 
+#if SVC_THREADS_POOL_SIZE
+/**
+ * @brief   Completes the worker's job and parks the worker in the pool.
+ *
+ * @return              true if parked, false if the pool is full and the
+ *                      worker must exit to be joined.
+ *
+ * @notapi
+ */
+static bool
+svc_threads_park (SVC_THREADS_WORKER_T * worker)
+{
+    SVC_THREADS_T* job ;
+    bool parked = false ;
+
+    os_mutex_lock(&_svc_threads_mutex) ;
+    job = worker->job ;
+    if (_svc_threads_pool_count < SVC_THREADS_POOL_SIZE) {
+        job->worker = 0 ;
+        _svc_threads_pool_count++ ;
+        linked_add_head (&_svc_threads_pool, worker, OFFSETOF(SVC_THREADS_WORKER_T, next)) ;
+        parked = true ;
+
+    }
+    svc_threads_retire (job) ;
+    os_mutex_unlock(&_svc_threads_mutex) ;
+
+    return parked ;
+}
+
+/**
+ * @brief   Clears what the previous job left on the calling worker: a
+ *          notification sent but not taken and its TLS slots.
+ *
+ * @notapi
+ */
+static void
+svc_threads_worker_reset (void)
+{
+    int32_t i ;
+
+    os_thread_notify_clear () ;
+    for (i = 0 ; os_thread_tls_set (i, 0) == EOK ; i++) ;
+}
+
+static void
+svc_threads_worker (void * parm)
+{
+    SVC_THREADS_WORKER_T * worker = (SVC_THREADS_WORKER_T *)parm ;
+
+    do {
+        SVC_THREADS_T* job = worker->job ;
+        svc_threads_worker_reset () ;
+        svc_threads_set_current (job) ;
+        job->pf (job->arg) ;
+        if (os_thread_get_prio () != worker->prio) {
+            os_thread_set_prio (&worker->thread, worker->prio) ;
+        }
+        if (!svc_threads_park (worker)) {
+            break ;
+        }
+        os_sem_wait (&worker->sem) ;
+
+    } while (1) ;
+}
+
+/**
+ * @brief   Runs thread on a parked worker with a matching stack size and
+ *          priority, or on a new one. Called with the mutex locked.
+ * @note    A reused OS thread keeps the name it was created with, and the
+ *          stack high-water mark of the jobs it ran before, so the stack
+ *          use reported for the job is the worst of all of them.
+ *
+ * @notapi
+ */
+static int32_t
+svc_threads_pool_start (SVC_THREADS_T* thread, size_t stack_size, uint32_t prio,
+                            const char* name)
+{
+    SVC_THREADS_WORKER_T * worker ;
+    int32_t res ;
+
+    for ( worker = (SVC_THREADS_WORKER_T*)linked_head (&_svc_threads_pool) ;
+        (worker!=NULL_LLO)
+            ; ) {
+        if ((worker->stack_size == stack_size) && (worker->prio == prio)) {
+            break ;
+        }
+        worker = (SVC_THREADS_WORKER_T*)linked_next (worker, OFFSETOF(SVC_THREADS_WORKER_T, next));
+    }
+
+    if (worker) {
+        _svc_threads_pool_count-- ;
+        linked_remove (&_svc_threads_pool, worker, OFFSETOF(SVC_THREADS_WORKER_T, next)) ;
+        worker->job = thread ;
+        thread->worker = worker ;
+        thread->thread = worker->thread ;
+        os_sem_signal (&worker->sem) ;
+        return EOK ;
+
+    }
+
+    worker = qoraal_malloc (QORAAL_HeapOperatingSystem, sizeof(SVC_THREADS_WORKER_T)) ;
+    if (!worker) {
+        return E_NOMEM ;
+    }
+    if (os_sem_create (&worker->sem, 0) != EOK) {
+        qoraal_free (QORAAL_HeapOperatingSystem, worker) ;
+        return E_NOMEM ;
+    }
+    worker->next = 0 ;
+    worker->job = thread ;
+    worker->stack_size = stack_size ;
+    worker->prio = prio ;
+    thread->worker = worker ;
+
+    res = os_thread_create (stack_size, prio, svc_threads_worker,
+                            worker, &worker->thread, name) ;
+    if (res != EOK) {
+        os_sem_delete (&worker->sem) ;
+        qoraal_free (QORAAL_HeapOperatingSystem, worker) ;
+        return res ;
+    }
+    thread->thread = worker->thread ;
+
+    return EOK ;
+}
+#else
 static void 
 svc_thread_start (void * parm)
 {
     SVC_THREADS_T* svc_thread = (SVC_THREADS_T*)parm ;
+    svc_threads_set_current (svc_thread) ;
     svc_thread->pf (svc_thread->arg) ;
-    svc_threads_terminate () ;
+    svc_threads_terminate (svc_thread) ;
 }
+#endif
 
 /**
  * @brief   svc_threads_create
@@ -122,14 +373,19 @@ svc_threads_create (SVC_THREADS_T* thread, SVC_THREADS_COMPLETE_CALLBACK_T compl
     thread->arg = arg ;
     thread->complete = complete ;
     thread->pf = pf ;
+    thread->name = name ;
 
     if (os_sys_started()) os_mutex_lock(&_svc_threads_mutex) ;
+#if SVC_THREADS_POOL_SIZE
+    res = svc_threads_pool_start (thread, stack_size, prio, name) ;
+#else
+    thread->worker = 0 ;
     res = os_thread_create (stack_size, prio, svc_thread_start,
                             thread, &thread->thread, name) ;
+#endif
 
     if (res == EOK) {
-        _svc_threads_list_count++ ;
-        linked_add_tail (&_svc_threads_list, thread, OFFSETOF(SVC_THREADS_T, next)) ;
+        svc_threads_list_add (thread) ;
 
         DBG_MESSAGE_SVC_THREADS (DBG_MESSAGE_SEVERITY_INFO, 
                 "SVC   : : svc_threads_register '%s' (0x%x -> 0x%x) count %d",
@@ -144,53 +400,24 @@ svc_threads_create (SVC_THREADS_T* thread, SVC_THREADS_COMPLETE_CALLBACK_T compl
     return res ;
 }
 
+#if !SVC_THREADS_POOL_SIZE
 /**
  * @brief   svc_threads_terminate
  * @note    move the thread to the start of the list for cleanup.
  *
- * @param[in] arg  argument for callback function
- *
- * @return              Error.
+ * @param[in] svc_thread    the calling thread
  *
  * @svc
  */
 void
-svc_threads_terminate (void)
+svc_threads_terminate (SVC_THREADS_T* svc_thread)
 {
-    p_thread_t  thread ;
-    SVC_THREADS_T* start ;
-
     os_mutex_lock(&_svc_threads_mutex) ;
-    thread = os_thread_current () ;
-
-    for ( start = (SVC_THREADS_T*)linked_head (&_svc_threads_list) ;
-        (start!=NULL_LLO)
-            ; ) {
-
-        if (thread == start->thread) {
-            DBG_MESSAGE_SVC_THREADS (DBG_MESSAGE_SEVERITY_INFO, 
-                "SVC   : : svc_threads_terminate (obj 0x%x, thd 0x%x)",
-                start, start->thread) ;
-             break ;
-        }
-
-        start = (SVC_THREADS_T*)linked_next (start, OFFSETOF(SVC_THREADS_T, next));
-    }
-
-    if (start) {
-        _svc_threads_list_count-- ;
-        linked_remove (&_svc_threads_list, start, OFFSETOF(SVC_THREADS_T, next)) ;
-        linked_add_head (&_svc_threads_complete, start, OFFSETOF(SVC_THREADS_T, next)) ;
-
-#if !defined CFG_SVC_THREADS_DISABLE_IDLE
-        os_sem_signal (&_svc_threads_sem) ;
-#endif
-
-    }
-
+    svc_threads_retire (svc_thread) ;
     os_mutex_unlock(&_svc_threads_mutex) ;
 
 }
+#endif
 
 static inline int32_t
 svc_threads_complete_check (void)
@@ -213,7 +440,17 @@ svc_threads_complete_check (void)
                 "SVC   : : svc_threads_complete_check delete %x",
                 thread) ;
 
+#if SVC_THREADS_POOL_SIZE
+        if (start->worker) {
+            /* the pool was full, the worker exited */
+            os_thread_join (&thread) ;
+            os_sem_delete (&start->worker->sem) ;
+            qoraal_free (QORAAL_HeapOperatingSystem, start->worker) ;
+            start->worker = 0 ;
+        }
+#else
         os_thread_join (&thread) ;
+#endif
 
         SVC_THREADS_COMPLETE_CALLBACK_T complete = start->complete ;
         void* arg = start->arg ;
@@ -265,6 +502,70 @@ svc_threads_is_active (SVC_THREADS_T* svc_thread)
     return svc_thread->pf != 0 ;
 }
 
+/**
+ * @brief   svc_threads_current
+ *
+ * @return              the SVC_THREADS_T of the calling thread or 0 if it was
+ *                      not created with svc_threads_create().
+ *
+ * @svc
+ */
+SVC_THREADS_T*
+svc_threads_current (void)
+{
+    SVC_THREADS_T* start ;
+    p_thread_t thread ;
+
+    if (_svc_threads_tls_valid) {
+        /* Set before pf runs, 0 for threads not created here. */
+        uint64_t value = 0 ;
+        uint32_t i = SVC_THREADS_TLS_SLOTS ;
+        while (i--) {
+            value = (value << 32) | os_thread_tls_get (_svc_threads_tls[i]) ;
+        }
+        return (SVC_THREADS_T*)(uintptr_t)value ;
+    }
+
+    thread = os_thread_current () ;
+    os_mutex_lock(&_svc_threads_mutex) ;
+    for (start = _svc_threads_list_head ; start ; start = start->next) {
+        if (start->thread == thread) {
+            break ;
+        }
+    }
+    os_mutex_unlock(&_svc_threads_mutex) ;
+
+    return start ;
+}
+
+/**
+ * @brief   svc_threads_enum
+ * @note    fp is called with the thread list locked and may not create
+ *          threads or wait for them to complete.
+ *
+ * @param[in] fp            called for every running thread, oldest first
+ * @param[in] arg           argument for fp
+ *
+ * @return              number of threads.
+ *
+ * @svc
+ */
+uint32_t
+svc_threads_enum (SVC_THREADS_ENUM_CALLBACK_T fp, void* arg)
+{
+    SVC_THREADS_T* start ;
+    uint32_t count = 0 ;
+
+    os_mutex_lock(&_svc_threads_mutex) ;
+    for (start = _svc_threads_list_head ; start ; start = start->next) {
+        fp (arg, start) ;
+        count++ ;
+    }
+    os_mutex_unlock(&_svc_threads_mutex) ;
+
+    return count ;
+}
+
 /**
  * @brief   vApplicationIdleHook
  * @note    FreeRTOS idle hook to call cleanup function for terminated threads.
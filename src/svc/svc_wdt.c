@@ -25,6 +25,7 @@
 
 
 
+#include <string.h>
 #include "qoraal/config.h"
 #include "qoraal/qoraal.h"
 #include "qoraal/svc/svc_wdt.h"
@@ -32,21 +33,54 @@
 #include "qoraal/common/lists.h"
 
 
-#define SVC_WDT_FLAGS_ACTIVE                (1<<0)
-#define SVC_WDT_FLAGS_KICKED                (1<<1)
 #define SVC_WDT_FLAGS_FLAGGED               (1<<2)
 #define SVC_WDT_FLAGS_REPORTED              (1<<3)
 
+#ifndef SVC_WDT_HEAP_SIZE
+#define SVC_WDT_HEAP_SIZE                   16
+#endif
+
+#define SVC_WDT_BEFORE(a, b)                ((int32_t)((a) - (b)) < 0)
+
+/* deadlines for the fixed timeout groups */
+static const uint32_t       _svc_wdt_timeouts[TIMEOUT_LAST] = { 10000, 30000, 60000 } ;
 
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
 
+typedef struct SVC_WDT_HEAP_S {
+    uint32_t                size ;
+    SVC_WDT_HANDLE_T *      handler[] ;
+} SVC_WDT_HEAP_T ;
+
 static void     svc_wdt_task_cb (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason) ;
-static uint8_t  svc_wdt_process (SVC_WDT_TIMEOUTS_T id) ;
 
 static uint32_t             _svc_wdt_interval = 0 ;
 static OS_MUTEX_DECL        (_svc_wdt_mutex) ;
-static stack_t              _svc_wdt_handler_stack[TIMEOUT_LAST] ;
-static uint32_t             _svc_wdt_counter = 0 ;
+/*
+ * Registered handlers. Register and unregister change the list under the
+ * mutex and then bump _svc_wdt_gen, the checker walks it without a lock.
+ */
+static SVC_WDT_HANDLE_T * volatile _svc_wdt_handlers = 0 ;
+static uint32_t             _svc_wdt_registered = 0 ;
+static uint32_t             _svc_wdt_gen = 0 ;
+/*
+ * Odd while the checker runs. Unregister waits out a run in progress
+ * before the handler can be reused, a run that starts later sees the new
+ * _svc_wdt_gen.
+ */
+static uint32_t             _svc_wdt_scan = 0 ;
+/*
+ * The checker's binary min heap of the handlers on the time of their next
+ * check, so it only wakes up for the nearest deadline. Only the checker
+ * touches it, rebuilding it from the list when _svc_wdt_gen changed.
+ * Register swaps in a larger one before the list outgrows it.
+ */
+static SVC_WDT_HEAP_T * volatile _svc_wdt_heap = 0 ;
+static SVC_WDT_HEAP_T *     _svc_wdt_built = 0 ;
+static uint32_t             _svc_wdt_built_gen = 0 ;
+static uint32_t             _svc_wdt_count = 0 ;
+static uint32_t             _svc_wdt_reported = 0 ;
+static uint32_t             _svc_wdt_kick_due = 0 ;
 static SVC_TASKS_DECL		(_svc_wdt_task)  ;
 #endif
 
@@ -60,17 +94,158 @@ int32_t
 svc_wdt_init (void)
 {
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
-    int i ;
     DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_INFO, " -->> svc_wdt_init") ;
     os_mutex_init (&_svc_wdt_mutex) ;
 
-    for (i=0; i<TIMEOUT_LAST; i++) {
-        stack_init (&_svc_wdt_handler_stack[i]) ;
-    }
+    _svc_wdt_handlers = 0 ;
+    _svc_wdt_registered = 0 ;
 #endif
     return EOK ;
 }
 
+#ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+/**
+ * @brief   Deadline of the handler in ticks, at least two so half of it is
+ *          never zero.
+ *
+ * @notapi
+ */
+static uint32_t
+svc_wdt_ticks (SVC_WDT_HANDLE_T * handler)
+{
+    uint32_t ticks = OS_MS2TICKS(handler->timeout) ;
+    return ticks < 2 ? 2 : ticks ;
+}
+
+static void
+svc_wdt_heap_up (uint32_t i)
+{
+    SVC_WDT_HANDLE_T ** heap = _svc_wdt_built->handler ;
+    SVC_WDT_HANDLE_T * handler = heap[i] ;
+    uint32_t parent ;
+
+    while (i) {
+        parent = (i - 1) / 2 ;
+        if (!SVC_WDT_BEFORE(handler->due, heap[parent]->due)) {
+            break ;
+        }
+        heap[i] = heap[parent] ;
+        i = parent ;
+    }
+    heap[i] = handler ;
+}
+
+static void
+svc_wdt_heap_down (uint32_t i)
+{
+    SVC_WDT_HANDLE_T ** heap = _svc_wdt_built->handler ;
+    SVC_WDT_HANDLE_T * handler = heap[i] ;
+    uint32_t child ;
+
+    while ((child = 2 * i + 1) < _svc_wdt_count) {
+        if ((child + 1 < _svc_wdt_count) &&
+                SVC_WDT_BEFORE(heap[child + 1]->due, heap[child]->due)) {
+            child++ ;
+        }
+        if (!SVC_WDT_BEFORE(heap[child]->due, handler->due)) {
+            break ;
+        }
+        heap[i] = heap[child] ;
+        i = child ;
+    }
+    heap[i] = handler ;
+}
+
+/**
+ * @brief   Rebuilds the heap from the handler list if a register or
+ *          unregister changed it since the last run. Only called by the
+ *          checker.
+ *
+ * @notapi
+ */
+static void
+svc_wdt_heap_build (void)
+{
+    SVC_WDT_HEAP_T * heap ;
+    SVC_WDT_HANDLE_T * handler ;
+    uint32_t gen = OS_ATOMIC_LOAD (&_svc_wdt_gen) ;
+
+    OS_ATOMIC_FENCE () ;
+    heap = _svc_wdt_heap ;
+    if ((gen == _svc_wdt_built_gen) && (heap == _svc_wdt_built)) {
+        return ;
+    }
+
+    _svc_wdt_built = heap ;
+    _svc_wdt_built_gen = gen ;
+    _svc_wdt_count = 0 ;
+    _svc_wdt_reported = 0 ;
+    if (!heap) {
+        return ;
+    }
+
+    for (handler = _svc_wdt_handlers ;
+            handler && (_svc_wdt_count < heap->size) ;
+            handler = handler->next) {
+        if (handler->flags & SVC_WDT_FLAGS_REPORTED) {
+            _svc_wdt_reported++ ;
+        }
+        heap->handler[_svc_wdt_count] = handler ;
+        svc_wdt_heap_up (_svc_wdt_count++) ;
+    }
+}
+
+/**
+ * @brief   Publishes a change to the handler list and waits out a checker
+ *          run that may still use a handler taken off it or the heap it
+ *          replaced. Called with the mutex locked.
+ *
+ * @param[in] old           heap replaced by a larger one, freed, or 0
+ *
+ * @notapi
+ */
+static void
+svc_wdt_changed (SVC_WDT_HEAP_T * old)
+{
+    uint32_t scan ;
+
+    OS_ATOMIC_FENCE () ;
+    OS_ATOMIC_INC (&_svc_wdt_gen) ;
+    OS_ATOMIC_FENCE () ;
+    scan = OS_ATOMIC_LOAD (&_svc_wdt_scan) ;
+    while ((scan & 1) && (OS_ATOMIC_LOAD (&_svc_wdt_scan) == scan)) {
+        os_thread_sleep (1) ;
+    }
+
+    if (old) {
+        qoraal_free (QORAAL_HeapAuxiliary, old) ;
+    }
+}
+
+/**
+ * @brief   Takes handler off the list if it is on it. Called with the mutex
+ *          locked.
+ * @note    The handler may be uninitialised, it is only looked for.
+ *
+ * @notapi
+ */
+static void
+svc_wdt_remove (SVC_WDT_HANDLE_T * handler)
+{
+    SVC_WDT_HANDLE_T * volatile * prev ;
+
+    for (prev = &_svc_wdt_handlers; *prev; prev = &(*prev)->next) {
+        if (*prev == handler) {
+            /* handler->next stays valid for a walk that is on handler */
+            *prev = handler->next ;
+            _svc_wdt_registered-- ;
+            svc_wdt_changed (0) ;
+            break ;
+        }
+    }
+}
+#endif
+
 /**
  * @brief   Start the wdt.
  *
@@ -81,18 +256,19 @@ int32_t
 svc_wdt_start (void)
 {
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+    os_mutex_lock (&_svc_wdt_mutex) ;
     _svc_wdt_interval = qoraal_wdt_kick () ;
 
     if (_svc_wdt_interval) {
-        svc_tasks_cancel (&_svc_wdt_task) ;
-        return svc_tasks_schedule (&_svc_wdt_task, svc_wdt_task_cb, 0, SERVICE_PRIO_QUEUE0, SVC_TASK_S2TICKS(_svc_wdt_interval/2)) ;
+        _svc_wdt_kick_due = os_sys_ticks () + OS_S2TICKS(_svc_wdt_interval) / 2 ;
+        /* E_BUSY if the checker is already queued */
+        svc_tasks_schedule (&_svc_wdt_task, svc_wdt_task_cb, 0, SERVICE_PRIO_QUEUE0, 0) ;
 
     }
+    os_mutex_unlock (&_svc_wdt_mutex) ;
+#endif
 
     return EOK ;
-#else
-    return EOK ;
-#endif
 }
 
 /**
@@ -105,6 +281,9 @@ void
 svc_wdt_stop (void)
 {
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+    os_mutex_lock (&_svc_wdt_mutex) ;
+    _svc_wdt_interval = 0 ;
+    os_mutex_unlock (&_svc_wdt_mutex) ;
     svc_tasks_cancel (&_svc_wdt_task) ;
 
 #endif
@@ -124,20 +303,84 @@ svc_wdt_stop (void)
 void
 svc_wdt_register (SVC_WDT_HANDLE_T * handler, SVC_WDT_TIMEOUTS_T id)
 {
+    svc_wdt_register_ms (handler,
+            _svc_wdt_timeouts[id < TIMEOUT_LAST ? id : TIMEOUT_10_SEC]) ;
+}
+
+/**
+ * @brief   Register a watchdog handler listener with its own deadline.
+ * @note    The handler is flagged when it was not kicked for half the
+ *          deadline and reported, holding back the hardware watchdog, when
+ *          it was not kicked for the whole deadline.
+ *
+ * @param[in] handler       Caller allocated handle structure
+ * @param[in] timeout_ms    Deadline between kicks while active
+ *
+ * @svc
+ */
+void
+svc_wdt_register_ms (SVC_WDT_HANDLE_T * handler, uint32_t timeout_ms)
+{
+#ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+    SVC_WDT_HEAP_T * old = 0 ;
+    SVC_WDT_HEAP_T * heap ;
+    uint32_t size ;
+    uint32_t now ;
+#endif
+
+    if (timeout_ms < 2) {
+        timeout_ms = 2 ;
+    }
+
+#ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+    os_mutex_lock (&_svc_wdt_mutex) ;
+
+    svc_wdt_remove (handler) ;
     memset (handler, 0, sizeof(SVC_WDT_HANDLE_T)) ;
     handler->thread = os_thread_current () ;
-    handler->timeout = id ;
-#ifndef CFG_SVC_WDT_DISABLE_PLATFORM
-    if (id < TIMEOUT_LAST) {
-        os_mutex_lock (&_svc_wdt_mutex) ;
+    handler->timeout = timeout_ms ;
+    now = os_sys_ticks () ;
+    handler->kicked = now ;
+    handler->due = now + svc_wdt_ticks (handler) / 2 ;
+
+    heap = _svc_wdt_heap ;
+    if (!heap || (_svc_wdt_registered == heap->size)) {
+        size = heap ? heap->size * 2 : SVC_WDT_HEAP_SIZE ;
+        heap = qoraal_malloc (QORAAL_HeapAuxiliary,
+                sizeof(SVC_WDT_HEAP_T) + size * sizeof(SVC_WDT_HANDLE_T *)) ;
+        if (heap) {
+            /* the checker fills it on its next run */
+            heap->size = size ;
+            old = _svc_wdt_heap ;
+            _svc_wdt_heap = heap ;
+        }
+    }
 
-        stack_remove (&_svc_wdt_handler_stack[id], (plists_t)handler, OFFSETOF(SVC_WDT_HANDLE_T, next)) ;
-        stack_add_head (&_svc_wdt_handler_stack[id], handler, OFFSETOF(SVC_WDT_HANDLE_T, next)) ;
+    if (!heap) {
+        DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_WARNING,
+                "WDT   : : no memory to watch '%s'",
+                os_thread_get_name(&handler->thread)) ;
+
+    } else {
+        handler->next = _svc_wdt_handlers ;
+        /* the checker may walk the list, publish the handler complete */
+        OS_ATOMIC_FENCE () ;
+        _svc_wdt_handlers = handler ;
+        _svc_wdt_registered++ ;
+        /*
+         * The checker picks the handler up on its next run, at the latest
+         * with the next hardware kick, and checks it before that kick.
+         */
+        svc_wdt_changed (old) ;
 
-        os_mutex_unlock (&_svc_wdt_mutex) ;
     }
+
+    os_mutex_unlock (&_svc_wdt_mutex) ;
+#else
+    memset (handler, 0, sizeof(SVC_WDT_HANDLE_T)) ;
+    handler->thread = os_thread_current () ;
+    handler->timeout = timeout_ms ;
 #endif
-    return  ;
 }
 
 /**
@@ -151,12 +394,11 @@ svc_wdt_register (SVC_WDT_HANDLE_T * handler, SVC_WDT_TIMEOUTS_T id)
 void 
 svc_wdt_unregister (SVC_WDT_HANDLE_T * handler, SVC_WDT_TIMEOUTS_T id)
 {
+    (void)id ;
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
-    if (id < TIMEOUT_LAST) {
-        os_mutex_lock (&_svc_wdt_mutex) ;
-        stack_remove (&_svc_wdt_handler_stack[id], (plists_t)handler, OFFSETOF(SVC_WDT_HANDLE_T, next)) ;
-        os_mutex_unlock (&_svc_wdt_mutex) ;
-    }
+    os_mutex_lock (&_svc_wdt_mutex) ;
+    svc_wdt_remove (handler) ;
+    os_mutex_unlock (&_svc_wdt_mutex) ;
 #endif
 }
 
@@ -165,29 +407,104 @@ svc_wdt_unregister (SVC_WDT_HANDLE_T * handler, SVC_WDT_TIMEOUTS_T id)
  *
  * @param[in] handler       Caller allocated handle structure
  *
- * @return              Timeout value in seconds, or -1 if invalid.
+ * @return              Timeout value in seconds, rounded up.
  *
  * @svc
  */
 uint32_t
 svc_wdt_timeout (SVC_WDT_HANDLE_T * handler)
 {
-    if (handler->timeout == TIMEOUT_10_SEC) return 10 ;
-    else if (handler->timeout == TIMEOUT_30_SEC) return 30 ;
-    else if (handler->timeout == TIMEOUT_60_SEC) return 60 ;
-    return 10 ;
+    return (handler->timeout + 999) / 1000 ;
 }
 
-void
-svc_wdt_activate (SVC_WDT_HANDLE_T * handler)
+/**
+ * @brief   Get the timeout value for a watchdog handler.
+ *
+ * @param[in] handler       Caller allocated handle structure
+ *
+ * @return              Timeout value in milliseconds.
+ *
+ * @svc
+ */
+uint32_t
+svc_wdt_timeout_ms (SVC_WDT_HANDLE_T * handler)
+{
+    return handler->timeout ;
+}
+
+/**
+ * @brief   Longest time the handler went without a kick while active.
+ *
+ * @param[in] handler       Caller allocated handle structure
+ *
+ * @return              Interval in milliseconds.
+ *
+ * @svc
+ */
+uint32_t
+svc_wdt_max_interval (SVC_WDT_HANDLE_T * handler)
+{
+    return OS_TICKS2MS(OS_ATOMIC_LOAD (&handler->max_interval)) ;
+}
+
+/**
+ * @brief   svc_wdt_enum
+ * @note    fp is called with the mutex locked and may not register or
+ *          unregister handlers.
+ *
+ * @param[in] fp            called for every registered handler, in no
+ *                          particular order
+ * @param[in] arg           argument for fp
+ *
+ * @return              number of handlers.
+ *
+ * @svc
+ */
+uint32_t
+svc_wdt_enum (SVC_WDT_ENUM_CALLBACK_T fp, void* arg)
 {
+    uint32_t count = 0 ;
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
-    p_thread_t thread = os_thread_current () ;
+    SVC_WDT_HANDLE_T * handler ;
+
     os_mutex_lock (&_svc_wdt_mutex) ;
-    handler->thread = thread ;
-    handler->flags = (SVC_WDT_FLAGS_ACTIVE|SVC_WDT_FLAGS_KICKED) ;
+    for (handler = _svc_wdt_handlers; handler; handler = handler->next) {
+        fp (arg, handler) ;
+    }
+    count = _svc_wdt_registered ;
     os_mutex_unlock (&_svc_wdt_mutex) ;
 #endif
+
+    return count ;
+}
+
+#ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+/**
+ * @brief   Ends the interval since the last kick, keeping the longest.
+ *          Only called by the owning thread.
+ *
+ * @notapi
+ */
+static void
+svc_wdt_stamp (SVC_WDT_HANDLE_T * handler, uint32_t now)
+{
+    uint32_t interval = now - handler->kicked ;
+
+    if (interval > handler->max_interval) {
+        OS_ATOMIC_STORE (&handler->max_interval, interval) ;
+    }
+    OS_ATOMIC_STORE (&handler->kicked, now) ;
+}
+#endif
+
+void
+svc_wdt_activate (SVC_WDT_HANDLE_T * handler)
+{
+#ifndef CFG_SVC_WDT_DISABLE_PLATFORM
+    handler->thread = os_thread_current () ;
+    OS_ATOMIC_STORE (&handler->kicked, os_sys_ticks ()) ;
+    OS_ATOMIC_STORE (&handler->active, 1) ;
+#endif
 }
 
 void
@@ -208,9 +525,11 @@ svc_wdt_deactivate (SVC_WDT_HANDLE_T * handler)
 
     }
 
-    os_mutex_lock (&_svc_wdt_mutex) ;
-    handler->flags &= ~(SVC_WDT_FLAGS_ACTIVE|SVC_WDT_FLAGS_KICKED|SVC_WDT_FLAGS_FLAGGED|SVC_WDT_FLAGS_REPORTED) ;
-    os_mutex_unlock (&_svc_wdt_mutex) ;
+    if (handler->active) {
+        svc_wdt_stamp (handler, os_sys_ticks ()) ;
+    }
+    /* the checker clears flagged and reported */
+    OS_ATOMIC_STORE (&handler->active, 0) ;
 #endif
 }
 
@@ -218,17 +537,14 @@ void
 svc_wdt_handler_kick (SVC_WDT_HANDLE_T * handler)
 {
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
-    if (handler->flags & SVC_WDT_FLAGS_REPORTED) {
-        DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_REPORT,
-                "WDT   : : kick '%s' (0x%x) as reported",
-                os_thread_get_name(&handler->thread), handler->id) ;
+    uint32_t now = os_sys_ticks () ;
 
+    /* the checker only compares kicked against its deadline, no lock needed */
+    if (handler->active) {
+        svc_wdt_stamp (handler, now) ;
+    } else {
+        OS_ATOMIC_STORE (&handler->kicked, now) ;
     }
-
-    os_mutex_lock (&_svc_wdt_mutex) ;
-    handler->flags |= SVC_WDT_FLAGS_KICKED ;
-    handler->flags &= ~(SVC_WDT_FLAGS_REPORTED|SVC_WDT_FLAGS_FLAGGED) ;
-    os_mutex_unlock (&_svc_wdt_mutex) ;
 #endif
 }
 
@@ -243,54 +559,77 @@ svc_wdt_kick (void)
 }
 
 #ifndef CFG_SVC_WDT_DISABLE_PLATFORM
-uint8_t
-svc_wdt_process (SVC_WDT_TIMEOUTS_T id)
+static void
+svc_wdt_clear (SVC_WDT_HANDLE_T * handler)
 {
-    int kick = 1 ;
-    SVC_WDT_HANDLE_T* start ;
-
-    for ( start = (SVC_WDT_HANDLE_T*)stack_head (&_svc_wdt_handler_stack[id]) ;
-        (start!=NULL_LLO)
-            ; ) {
-
-        if (start->flags & SVC_WDT_FLAGS_ACTIVE) {
-
-            if (start->flags & SVC_WDT_FLAGS_KICKED) {
-                start->flags &= ~(SVC_WDT_FLAGS_KICKED|SVC_WDT_FLAGS_FLAGGED|SVC_WDT_FLAGS_REPORTED) ;
+    if (handler->flags & SVC_WDT_FLAGS_REPORTED) {
+        _svc_wdt_reported-- ;
+    }
+    handler->flags &= ~(SVC_WDT_FLAGS_FLAGGED|SVC_WDT_FLAGS_REPORTED) ;
+}
 
-            } else {
-                if (start->flags & SVC_WDT_FLAGS_FLAGGED) {
-
-                    if (!(start->flags & SVC_WDT_FLAGS_REPORTED)) {
-                        start->flags |= SVC_WDT_FLAGS_REPORTED ;
-                        DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_WARNING,
-                            "WDT   : : reported '%s' (0x%x)",
-                            os_thread_get_name(&start->thread), start->id) ;
-                    }
-                    kick = 0 ;
-#if 0
-                    if (id == TIMEOUT_10_SEC) STATS_COUNTER_INC(wdt_10) ;
-                    else if (id == TIMEOUT_30_SEC) STATS_COUNTER_INC(wdt_30) ;
-                    else if (id == TIMEOUT_60_SEC) STATS_COUNTER_INC(wdt_60) ;
-#endif
-                } else {
+/**
+ * @brief   Checks a handler that is due and sets when it is due next. Only
+ *          called by the checker.
+ *
+ * @notapi
+ */
+static void
+svc_wdt_process (SVC_WDT_HANDLE_T * handler, uint32_t now)
+{
+    uint32_t timeout = svc_wdt_ticks (handler) ;
+    uint32_t elapsed ;
+    uint32_t retry ;
 
-                    start->flags |= SVC_WDT_FLAGS_FLAGGED ;
-                    DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_LOG,
-                            "WDT   : : flagging '%s' (0x%x)",
-                            os_thread_get_name(&start->thread), start->id) ;
+    if (!OS_ATOMIC_LOAD (&handler->active)) {
+        svc_wdt_clear (handler) ;
+        /* an activation in the meantime is caught within half the deadline */
+        handler->due = now + timeout / 2 ;
+        return ;
 
-                }
+    }
 
-            }
+    elapsed = now - OS_ATOMIC_LOAD (&handler->kicked) ;
+    if ((int32_t)elapsed < 0) {
+        /* kicked after now was read */
+        elapsed = 0 ;
+    }
 
+    if (elapsed < timeout / 2) {
+        if (handler->flags & SVC_WDT_FLAGS_REPORTED) {
+            DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_REPORT,
+                    "WDT   : : kick '%s' (0x%x) as reported",
+                    os_thread_get_name(&handler->thread), handler->id) ;
         }
-
-        start = (SVC_WDT_HANDLE_T*)stack_next ((plists_t)start, OFFSETOF(SVC_WDT_HANDLE_T, next));
+        svc_wdt_clear (handler) ;
+        handler->due = now - elapsed + timeout / 2 ;
+
+    } else if (elapsed < timeout) {
+        if (!(handler->flags & SVC_WDT_FLAGS_FLAGGED)) {
+            handler->flags |= SVC_WDT_FLAGS_FLAGGED ;
+            DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_LOG,
+                    "WDT   : : flagging '%s' (0x%x)",
+                    os_thread_get_name(&handler->thread), handler->id) ;
+        }
+        handler->due = now - elapsed + timeout ;
+
+    } else {
+        if (!(handler->flags & SVC_WDT_FLAGS_REPORTED)) {
+            handler->flags |= SVC_WDT_FLAGS_FLAGGED|SVC_WDT_FLAGS_REPORTED ;
+            _svc_wdt_reported++ ;
+            DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_WARNING,
+                "WDT   : : reported '%s' (0x%x) %u ms without a kick, max %u ms",
+                os_thread_get_name(&handler->thread), handler->id,
+                OS_TICKS2MS(elapsed), OS_TICKS2MS(handler->max_interval)) ;
+        }
+        /* look again in time to let the hardware watchdog be kicked */
+        retry = timeout / 2 ;
+        if (retry > OS_S2TICKS(_svc_wdt_interval) / 2) {
+            retry = OS_S2TICKS(_svc_wdt_interval) / 2 ;
+        }
+        handler->due = now + (retry ? retry : 1) ;
 
     }
-
-    return kick ;
 }
 
 static void
@@ -298,33 +637,51 @@ svc_wdt_task_cb (SVC_TASKS_T *task, uintptr_t parm, uint32_t reason)
 {
     if (reason == SERVICE_CALLBACK_REASON_RUN) {
 
-        static uint8_t kick10 = 1, kick30 = 1, kick60 = 1  ;
-        
-        os_mutex_lock (&_svc_wdt_mutex) ;
-        _svc_wdt_counter++ ;
-        kick10 = svc_wdt_process (TIMEOUT_10_SEC) ;
-        /* Timeout values describe the full reset window, so we check twice per window. */
-        if (!kick30 || !(_svc_wdt_counter%(30/_svc_wdt_interval))) {
-            kick30 = svc_wdt_process (TIMEOUT_30_SEC) ;
+        uint32_t now ;
+        uint32_t wake ;
+        uint32_t due = 0 ;
+        uint32_t count ;
+
+        OS_ATOMIC_INC (&_svc_wdt_scan) ;
+        OS_ATOMIC_FENCE () ;
+        now = os_sys_ticks () ;
+        svc_wdt_heap_build () ;
+
+        while (_svc_wdt_count && !SVC_WDT_BEFORE(now, _svc_wdt_built->handler[0]->due)) {
+            svc_wdt_process (_svc_wdt_built->handler[0], now) ;
+            svc_wdt_heap_down (0) ;
         }
-        if (!kick60 || !(_svc_wdt_counter%(60/_svc_wdt_interval))) {
-            kick60 = svc_wdt_process (TIMEOUT_60_SEC) ;
+        count = _svc_wdt_count ;
+        if (count) {
+            due = _svc_wdt_built->handler[0]->due ;
         }
+        OS_ATOMIC_FENCE () ;
+        OS_ATOMIC_INC (&_svc_wdt_scan) ;
+
+        if (_svc_wdt_interval && !SVC_WDT_BEFORE(now, _svc_wdt_kick_due)) {
+            if (!_svc_wdt_reported) {
+                _svc_wdt_interval =  qoraal_wdt_kick () ;
+                DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_INFO,
+                        "WDT   : : task kick");
 
-        if (kick10 && kick30 && kick60) {
-            _svc_wdt_interval =  qoraal_wdt_kick () ;
-            DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_INFO,
-                    "WDT   : : task kick");
+            } else {
+                DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_INFO,
+                        "WDT   : : task NOT kicked");
 
-        } else {
-            DBG_MESSAGE_SVC_WDT (DBG_MESSAGE_SEVERITY_INFO,
-                    "WDT   : : task NOT kicked");
+            }
+            /* timeout values describe the full reset window, kick twice per window */
+            _svc_wdt_kick_due = now + OS_S2TICKS(_svc_wdt_interval) / 2 ;
 
         }
-        os_mutex_unlock (&_svc_wdt_mutex) ;
 
         if (_svc_wdt_interval) {
-            svc_tasks_schedule (&_svc_wdt_task, svc_wdt_task_cb, 0, SERVICE_PRIO_QUEUE0, SVC_TASK_S2TICKS(_svc_wdt_interval/2)) ;
+            wake = _svc_wdt_kick_due ;
+            if (count && SVC_WDT_BEFORE(due, wake)) {
+                wake = due ;
+            }
+            /* E_BUSY if svc_wdt_start() queued it to run now */
+            svc_tasks_schedule (&_svc_wdt_task, svc_wdt_task_cb, 0, SERVICE_PRIO_QUEUE0,
+                    SVC_WDT_BEFORE(now, wake) ? wake - now : 0) ;
 
         }
 
@@ -27,6 +27,14 @@ static int32_t      qshell_demo_waitable_tasks (SVC_SHELL_IF_T * pif, char** arg
 static int32_t      qshell_demo_events (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
 static int32_t      qshell_demo_timers (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
 static int32_t      qshell_demo_dbg (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
+static int32_t      qshell_demo_notify (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
+static int32_t      qshell_demo_ratelimit (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
+#if !defined CFG_OS_RWLOCK_DISABLE
+static int32_t      qshell_demo_rwlock (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
+#endif
+#if !defined CFG_OS_QUEUE_DISABLE
+static int32_t      qshell_demo_queue (SVC_SHELL_IF_T * pif, char** argv, int argc) ;
+#endif
 
 
 SVC_SHELL_CMD_LIST_START(demo, QORAAL_SERVICE_DEMO)
@@ -36,6 +44,14 @@ SVC_SHELL_CMD_LIST( "demo_waitable_tasks", qshell_demo_waitable_tasks,  "")
 SVC_SHELL_CMD_LIST( "demo_events", qshell_demo_events,  "")
 SVC_SHELL_CMD_LIST( "demo_timers", qshell_demo_timers,  "")
 SVC_SHELL_CMD_LIST( "demo_dbg", qshell_demo_dbg,  "")
+SVC_SHELL_CMD_LIST( "demo_notify", qshell_demo_notify,  "")
+SVC_SHELL_CMD_LIST( "demo_ratelimit", qshell_demo_ratelimit,  "")
+#if !defined CFG_OS_RWLOCK_DISABLE
+SVC_SHELL_CMD_LIST( "demo_rwlock", qshell_demo_rwlock,  "")
+#endif
+#if !defined CFG_OS_QUEUE_DISABLE
+SVC_SHELL_CMD_LIST( "demo_queue", qshell_demo_queue,  "")
+#endif
 SVC_SHELL_CMD_LIST_END()
 
 /*===========================================================================*/
@@ -303,4 +319,416 @@ qshell_demo_dbg (SVC_SHELL_IF_T * pif, char** argv, int argc)
     svc_logger_type_mem (SVC_LOGGER_SEVERITY_REPORT, 0, mem, sizeof(mem), "MEM DUMP:\r\n", "\r\n") ;
 
     return SVC_SHELL_CMD_E_OK ;
-}
\ No newline at end of file
+}
+
+//==================================================================================================
+//  Test thread notifications
+//==================================================================================================
+
+typedef struct NOTIFY_TEST_S {
+    p_sem_t     go ;
+    p_sem_t     done ;
+    int32_t     res[7] ;
+} NOTIFY_TEST_T ;
+
+static void
+test_notify_thread (void *arg)
+{
+    NOTIFY_TEST_T * test = (NOTIFY_TEST_T*) arg ;
+
+    /* notified before it waits, the notification is kept */
+    os_sem_wait (&test->go) ;
+    test->res[0] = os_thread_wait (OS_MS2TICKS(10)) ;
+    test->res[1] = os_thread_wait (OS_MS2TICKS(10)) ;
+    os_sem_signal (&test->done) ;
+
+    /* three gives, taken one at a time and then cleared */
+    os_sem_wait (&test->go) ;
+    test->res[2] = os_thread_notify_take (0, OS_MS2TICKS(10)) ;
+    test->res[3] = os_thread_notify_take (0, OS_MS2TICKS(10)) ;
+    test->res[4] = os_thread_notify_take (1, OS_MS2TICKS(10)) ;
+    test->res[5] = os_thread_notify_take (1, OS_MS2TICKS(10)) ;
+    os_sem_signal (&test->done) ;
+
+    /* bits are or'ed together */
+    os_sem_wait (&test->go) ;
+    test->res[6] = os_thread_notify_take (1, OS_MS2TICKS(10)) ;
+}
+
+int32_t
+qshell_demo_notify (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    static const int32_t expect[7] = { 42, E_TIMEOUT, 3, 2, 1, 0, 7 } ;
+    NOTIFY_TEST_T test ;
+    p_thread_t thread ;
+    int32_t res = SVC_SHELL_CMD_E_OK ;
+    int i ;
+
+    memset (&test, 0, sizeof(test)) ;
+    if ((os_sem_create (&test.go, 0) != EOK) ||
+            (os_sem_create (&test.done, 0) != EOK) ||
+            (os_thread_create (1024, OS_THREAD_PRIO_5, test_notify_thread,
+                    (void*)&test, &thread, "test_notify") != EOK)) {
+        if (test.go) os_sem_delete (&test.go) ;
+        if (test.done) os_sem_delete (&test.done) ;
+        return SVC_SHELL_CMD_E_MEMORY ;
+    }
+
+    os_thread_notify (&thread, 42) ;
+    os_sem_signal (&test.go) ;
+    os_sem_wait (&test.done) ;
+
+    os_thread_notify_give (&thread) ;
+    os_thread_notify_give (&thread) ;
+    os_thread_notify_give (&thread) ;
+    os_sem_signal (&test.go) ;
+    os_sem_wait (&test.done) ;
+
+    os_thread_notify_bits (&thread, 0x5) ;
+    os_thread_notify_bits (&thread, 0x2) ;
+    os_sem_signal (&test.go) ;
+    os_thread_join (&thread) ;
+
+    for (i=0; i<7; i++) {
+        if (test.res[i] != expect[i]) {
+            svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                    "notify - step %d got %d expected %d.\r\n",
+                    i, (int)test.res[i], (int)expect[i]) ;
+            res = SVC_SHELL_CMD_E_FAIL ;
+        }
+    }
+
+    os_sem_delete (&test.go) ;
+    os_sem_delete (&test.done) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD,
+            "notify - test %s.\r\n", res == SVC_SHELL_CMD_E_OK ? "passed" : "failed") ;
+
+    return res ;
+}
+
+//==================================================================================================
+//  Test the call site rate limit
+//==================================================================================================
+
+#define RATELIMIT_TEST_MESSAGES         (3 * SVC_LOGGER_RATELIMIT_BURST)
+
+int32_t
+qshell_demo_ratelimit (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    const LOGGER_TYPE_T type = SVC_LOGGER_TYPE(SVC_LOGGER_SEVERITY_REPORT, 0) ;
+    SVC_LOGGER_STATS_T before ;
+    SVC_LOGGER_STATS_T after ;
+    uint32_t expect ;
+    uint32_t i ;
+
+    /* the limit is only consulted for messages some channel would take */
+    expect = SVC_LOGGER_ENABLED(type, QORAAL_SERVICE_DEMO) ?
+            RATELIMIT_TEST_MESSAGES - SVC_LOGGER_RATELIMIT_BURST : 0 ;
+
+    /* let the interval of a previous run expire */
+    os_thread_sleep (SVC_LOGGER_RATELIMIT_INTERVAL_MS) ;
+    svc_logger_get_stats (&before) ;
+    for (i=0; i<RATELIMIT_TEST_MESSAGES; i++) {
+        DBG_MESSAGE_T_RATELIMIT (type, QORAAL_SERVICE_DEMO,
+                "DEMO  : : ratelimit message %u", (unsigned int)i) ;
+    }
+    svc_logger_get_stats (&after) ;
+
+    if (after.ratelimited - before.ratelimited != expect) {
+        svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                "ratelimit - %u of %u suppressed, expected %u.\r\n",
+                (unsigned int)(after.ratelimited - before.ratelimited),
+                RATELIMIT_TEST_MESSAGES, (unsigned int)expect) ;
+    }
+    svc_shell_print (pif, SVC_SHELL_OUT_STD, "ratelimit - test %s.\r\n",
+            after.ratelimited - before.ratelimited == expect ? "passed" : "failed") ;
+
+    return after.ratelimited - before.ratelimited == expect ?
+            SVC_SHELL_CMD_E_OK : SVC_SHELL_CMD_E_FAIL ;
+}
+
+#if !defined CFG_OS_RWLOCK_DISABLE
+//==================================================================================================
+//  Test reader/writer locks
+//==================================================================================================
+
+#define RWLOCK_TEST_LOOPS           5000
+#define RWLOCK_TEST_READERS         3
+#define RWLOCK_TEST_WRITERS         2
+
+typedef struct RWLOCK_TEST_S {
+    p_rwlock_t  lock ;
+    uint32_t    readers ;
+    uint32_t    writers ;
+    uint32_t    errors ;
+} RWLOCK_TEST_T ;
+
+static void
+test_rwlock_reader (void *arg)
+{
+    RWLOCK_TEST_T * test = (RWLOCK_TEST_T*) arg ;
+    int i ;
+
+    for (i=0; i<RWLOCK_TEST_LOOPS; i++) {
+        os_rwlock_read_lock (&test->lock) ;
+        OS_ATOMIC_INC (&test->readers) ;
+        if (OS_ATOMIC_LOAD (&test->writers)) {
+            OS_ATOMIC_INC (&test->errors) ;
+        }
+        OS_ATOMIC_DEC (&test->readers) ;
+        os_rwlock_read_unlock (&test->lock) ;
+    }
+}
+
+static void
+test_rwlock_writer (void *arg)
+{
+    RWLOCK_TEST_T * test = (RWLOCK_TEST_T*) arg ;
+    int i ;
+
+    for (i=0; i<RWLOCK_TEST_LOOPS; i++) {
+        os_rwlock_write_lock (&test->lock) ;
+        if ((OS_ATOMIC_INC (&test->writers) != 1) ||
+                OS_ATOMIC_LOAD (&test->readers)) {
+            OS_ATOMIC_INC (&test->errors) ;
+        }
+        OS_ATOMIC_DEC (&test->writers) ;
+        os_rwlock_write_unlock (&test->lock) ;
+    }
+}
+
+static void
+test_rwlock_waiting_writer (void *arg)
+{
+    RWLOCK_TEST_T * test = (RWLOCK_TEST_T*) arg ;
+
+    os_rwlock_write_lock (&test->lock) ;
+    os_rwlock_write_unlock (&test->lock) ;
+}
+
+/**
+ * @brief   Runs readers and writers against a lock created with flags and
+ *          checks a writer never overlaps anyone, then whether a new reader
+ *          gets in past a waiting writer.
+ *
+ * @return              Number of errors.
+ */
+static uint32_t
+test_rwlock (SVC_SHELL_IF_T * pif, uint32_t flags)
+{
+    p_thread_t threads[RWLOCK_TEST_READERS + RWLOCK_TEST_WRITERS] ;
+    RWLOCK_TEST_T test ;
+    int32_t expect = (flags & OS_RWLOCK_FLAGS_WRITER_PREF) ? E_BUSY : EOK ;
+    int32_t res ;
+    int i ;
+
+    memset (&test, 0, sizeof(test)) ;
+    if (os_rwlock_create (&test.lock, flags) != EOK) {
+        return 1 ;
+    }
+
+    for (i=0; i<RWLOCK_TEST_READERS + RWLOCK_TEST_WRITERS; i++) {
+        if (os_thread_create (1024, OS_THREAD_PRIO_5,
+                i < RWLOCK_TEST_READERS ? test_rwlock_reader : test_rwlock_writer,
+                (void*)&test, &threads[i], "test_rwlock") != EOK) {
+            threads[i] = 0 ;
+            test.errors++ ;
+        }
+    }
+    for (i=0; i<RWLOCK_TEST_READERS + RWLOCK_TEST_WRITERS; i++) {
+        if (threads[i]) os_thread_join (&threads[i]) ;
+    }
+    if (test.errors) {
+        svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                "rwlock - %u overlaps with a writer.\r\n", (unsigned int)test.errors) ;
+    }
+
+    os_rwlock_read_lock (&test.lock) ;
+    if (os_thread_create (1024, OS_THREAD_PRIO_5, test_rwlock_waiting_writer,
+            (void*)&test, &threads[0], "test_rwlock") == EOK) {
+        os_thread_sleep (50) ;
+        res = os_rwlock_read_trylock (&test.lock) ;
+        if (res == EOK) {
+            os_rwlock_read_unlock (&test.lock) ;
+        }
+        if (res != expect) {
+            svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                    "rwlock - reader past a waiting writer got %d expected %d.\r\n",
+                    (int)res, (int)expect) ;
+            test.errors++ ;
+        }
+        os_rwlock_read_unlock (&test.lock) ;
+        os_thread_join (&threads[0]) ;
+
+    } else {
+        os_rwlock_read_unlock (&test.lock) ;
+        test.errors++ ;
+    }
+
+    os_rwlock_delete (&test.lock) ;
+
+    return test.errors ;
+}
+
+int32_t
+qshell_demo_rwlock (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    uint32_t readers = test_rwlock (pif, 0) ;
+    uint32_t writers = test_rwlock (pif, OS_RWLOCK_FLAGS_WRITER_PREF) ;
+
+    svc_shell_print (pif, SVC_SHELL_OUT_STD,
+            "rwlock - reader preference %s.\r\n", readers ? "failed" : "passed") ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD,
+            "rwlock - writer preference %s.\r\n", writers ? "failed" : "passed") ;
+
+    return (readers || writers) ? SVC_SHELL_CMD_E_FAIL : SVC_SHELL_CMD_E_OK ;
+}
+#endif
+
+#if !defined CFG_OS_QUEUE_DISABLE
+//==================================================================================================
+//  Test queues
+//==================================================================================================
+
+#define QUEUE_TEST_SIZE             16
+#define QUEUE_TEST_ITEMS            20000
+#define QUEUE_TEST_PRODUCERS        3
+#define QUEUE_TEST_CONSUMERS        3
+#define QUEUE_TEST_BATCH            4
+
+/* producer in the top bits, its sequence number from 1 in the bottom ones */
+#define QUEUE_TEST_ITEM(p, seq)     ((void*)(uintptr_t)(((p) << 16) | (seq)))
+
+typedef struct QUEUE_TEST_S {
+    p_queue_t   queue ;
+    uint32_t    producer ;
+    uint32_t    consumer ;
+    uint32_t    received[QUEUE_TEST_PRODUCERS] ;
+    uint32_t    total ;
+    uint32_t    errors ;
+} QUEUE_TEST_T ;
+
+static void
+test_queue_producer (void *arg)
+{
+    QUEUE_TEST_T * test = (QUEUE_TEST_T*) arg ;
+    uint32_t p = OS_ATOMIC_INC (&test->producer) - 1 ;
+    void * items[QUEUE_TEST_BATCH] ;
+    uint32_t seq = 1 ;
+    uint32_t n ;
+    uint32_t i ;
+
+    while (seq <= QUEUE_TEST_ITEMS) {
+        if (p & 1) {
+            /* odd producers put in batches, a batch may go in in parts */
+            n = QUEUE_TEST_ITEMS - seq + 1 ;
+            if (n > QUEUE_TEST_BATCH) n = QUEUE_TEST_BATCH ;
+            for (i=0; i<n; i++) {
+                items[i] = QUEUE_TEST_ITEM(p, seq + i) ;
+            }
+            seq += os_queue_put_batch (&test->queue, items, n, OS_TIME_INFINITE) ;
+
+        } else if (os_queue_put (&test->queue, QUEUE_TEST_ITEM(p, seq),
+                OS_TIME_INFINITE) == EOK) {
+            seq++ ;
+
+        }
+    }
+}
+
+static void
+test_queue_consumer (void *arg)
+{
+    QUEUE_TEST_T * test = (QUEUE_TEST_T*) arg ;
+    uint32_t c = OS_ATOMIC_INC (&test->consumer) - 1 ;
+    uint32_t last[QUEUE_TEST_PRODUCERS] = {0} ;
+    void * items[QUEUE_TEST_BATCH] ;
+    uint32_t idle = 0 ;
+    uint32_t n ;
+    uint32_t i ;
+    uint32_t p ;
+    uint32_t seq ;
+
+    /* done when all were received, or when nothing came for a second */
+    while ((OS_ATOMIC_LOAD (&test->total) <
+                QUEUE_TEST_PRODUCERS * QUEUE_TEST_ITEMS) && (idle < 50)) {
+        n = os_queue_get_batch (&test->queue, items,
+                (c & 1) ? QUEUE_TEST_BATCH : 1, OS_MS2TICKS(20)) ;
+        idle = n ? 0 : idle + 1 ;
+        for (i=0; i<n; i++) {
+            p = (uint32_t)(uintptr_t)items[i] >> 16 ;
+            seq = (uint32_t)(uintptr_t)items[i] & 0xFFFF ;
+            /* every consumer sees each producer's items in order */
+            if ((p >= QUEUE_TEST_PRODUCERS) || (seq <= last[p])) {
+                OS_ATOMIC_INC (&test->errors) ;
+                continue ;
+            }
+            last[p] = seq ;
+            OS_ATOMIC_INC (&test->received[p]) ;
+        }
+        OS_ATOMIC_ADD (&test->total, n) ;
+    }
+}
+
+int32_t
+qshell_demo_queue (SVC_SHELL_IF_T * pif, char** argv, int argc)
+{
+    p_thread_t threads[QUEUE_TEST_PRODUCERS + QUEUE_TEST_CONSUMERS] ;
+    QUEUE_TEST_T test ;
+    void * item ;
+    uint32_t i ;
+
+    memset (&test, 0, sizeof(test)) ;
+    if (os_queue_create (&test.queue, QUEUE_TEST_SIZE) != EOK) {
+        return SVC_SHELL_CMD_E_MEMORY ;
+    }
+
+    /* single threaded, fills to capacity and drains in order */
+    for (i=0; os_queue_put (&test.queue, QUEUE_TEST_ITEM(0, i + 1),
+            OS_TIME_IMMEDIATE) == EOK; i++) ;
+    if ((i != QUEUE_TEST_SIZE) || (os_queue_count (&test.queue) != QUEUE_TEST_SIZE)) {
+        svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                "queue - full after %u items, expected %u.\r\n",
+                (unsigned int)i, QUEUE_TEST_SIZE) ;
+        test.errors++ ;
+    }
+    for (i=0; os_queue_get (&test.queue, &item, OS_TIME_IMMEDIATE) == EOK; i++) {
+        if (item != QUEUE_TEST_ITEM(0, i + 1)) {
+            test.errors++ ;
+        }
+    }
+    if ((i != QUEUE_TEST_SIZE) || os_queue_count (&test.queue)) {
+        test.errors++ ;
+    }
+
+    for (i=0; i<QUEUE_TEST_PRODUCERS + QUEUE_TEST_CONSUMERS; i++) {
+        if (os_thread_create (1024, OS_THREAD_PRIO_5,
+                i < QUEUE_TEST_PRODUCERS ? test_queue_producer : test_queue_consumer,
+                (void*)&test, &threads[i], "test_queue") != EOK) {
+            /* the check below fails for the missing thread */
+            threads[i] = 0 ;
+        }
+    }
+    for (i=0; i<QUEUE_TEST_PRODUCERS + QUEUE_TEST_CONSUMERS; i++) {
+        if (threads[i]) os_thread_join (&threads[i]) ;
+    }
+
+    for (i=0; i<QUEUE_TEST_PRODUCERS; i++) {
+        if (test.received[i] != QUEUE_TEST_ITEMS) {
+            svc_shell_print (pif, SVC_SHELL_OUT_STD,
+                    "queue - producer %u: %u of %u items received.\r\n",
+                    (unsigned int)i, (unsigned int)test.received[i], QUEUE_TEST_ITEMS) ;
+            test.errors++ ;
+        }
+    }
+    if (os_queue_count (&test.queue)) {
+        test.errors++ ;
+    }
+
+    os_queue_delete (&test.queue) ;
+    svc_shell_print (pif, SVC_SHELL_OUT_STD,
+            "queue - test %s.\r\n", test.errors ? "failed" : "passed") ;
+
+    return test.errors ? SVC_SHELL_CMD_E_FAIL : SVC_SHELL_CMD_E_OK ;
+}
+#endif